@@ -0,0 +1,72 @@
+#include "cooked_model.hpp"
+#include "vertex_format.hpp"
+
+// NOTE: Names are fixed size so the tables can be read in place, they must be terminated
+static bool
+isTerminated(const char* text, size_t length) {
+    for (size_t CharIdx = 0; CharIdx < length; ++CharIdx) {
+        if (!text[CharIdx]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+ParseCookedModel(const unsigned char* data, size_t size, CookedModel* model) {
+    if (size < sizeof(CookedModelHeader)) {
+        return false;
+    }
+
+    const CookedModelHeader* Header = (const CookedModelHeader*)data;
+    if (Header->Magic != COOKED_MODEL_MAGIC || Header->Version != COOKED_MODEL_VERSION
+        || Header->VertexStride != sizeof(MeshVertex) || !Header->MeshCount) {
+        return false;
+    }
+
+    size_t MeshTableEnd = sizeof(CookedModelHeader) + (size_t)Header->MeshCount * sizeof(CookedModelMesh);
+    size_t TableEnd = MeshTableEnd + (size_t)Header->MaterialCount * sizeof(CookedModelMaterial);
+    if (size < TableEnd || Header->VertexOffset < TableEnd
+        || Header->IndexOffset < (size_t)Header->VertexOffset + Header->VertexSize
+        || (size_t)Header->IndexOffset + Header->IndexSize > size) {
+        return false;
+    }
+
+    const CookedModelMesh* Meshes = (const CookedModelMesh*)(data + sizeof(CookedModelHeader));
+    const CookedModelMaterial* Materials = (const CookedModelMaterial*)(data + MeshTableEnd);
+    const uint32_t* Indices = (const uint32_t*)(data + Header->IndexOffset);
+    size_t VertexCount = Header->VertexSize / sizeof(MeshVertex);
+    size_t IndexCount = Header->IndexSize / sizeof(uint32_t);
+    for (uint32_t MeshIdx = 0; MeshIdx < Header->MeshCount; ++MeshIdx) {
+        const CookedModelMesh& Mesh = Meshes[MeshIdx];
+        if ((size_t)Mesh.FirstVertex + Mesh.VertexCount > VertexCount || (size_t)Mesh.FirstIndex + Mesh.IndexCount > IndexCount
+            || (Header->MaterialCount && Mesh.Material >= Header->MaterialCount)) {
+            return false;
+        }
+        // NOTE: Out of range indices would read past the mesh when drawn,
+        // and wrap when narrowed to 16 bits for the compact format
+        for (uint32_t IndexIdx = Mesh.FirstIndex; IndexIdx < Mesh.FirstIndex + Mesh.IndexCount; ++IndexIdx) {
+            if (Indices[IndexIdx] >= Mesh.VertexCount) {
+                return false;
+            }
+        }
+    }
+    for (uint32_t MaterialIdx = 0; MaterialIdx < Header->MaterialCount; ++MaterialIdx) {
+        if (!isTerminated(Materials[MaterialIdx].Name, COOKED_MODEL_NAME_LENGTH)
+            || !isTerminated(Materials[MaterialIdx].DiffusePath, COOKED_MODEL_PATH_LENGTH)) {
+            return false;
+        }
+    }
+
+    model->Header = Header;
+    model->Meshes = Meshes;
+    model->Materials = Materials;
+    model->Vertices = data + Header->VertexOffset;
+    model->Indices = data + Header->IndexOffset;
+    return true;
+}
+
+std::string
+GetCookedModelPath(const std::string& sourcePath) {
+    return GetCookedPath(sourcePath, COOKED_MODEL_EXTENSION);
+}
@@ -0,0 +1,85 @@
+/**
+ * @file cooked_model.hpp
+ * @brief Cooked model container: every mesh already triangulated and
+ * interleaved as MeshVertex, vertices and indices each in one blob that
+ * can be handed to GL as is
+ *
+ */
+
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "cooked_path.hpp"
+
+static const std::string COOKED_MODEL_EXTENSION = ".cmdl";
+static const uint32_t COOKED_MODEL_MAGIC = 0x4C444D43; // "CMDL"
+// NOTE: 2 - vertices welded and meshes optimized, see OptimizeMesh
+static const uint32_t COOKED_MODEL_VERSION = 2;
+// NOTE: Blobs start on this boundary so they can be uploaded straight from the file
+static const unsigned COOKED_MODEL_BLOB_ALIGNMENT = 256;
+static const unsigned COOKED_MODEL_NAME_LENGTH = 64;
+static const unsigned COOKED_MODEL_PATH_LENGTH = 256;
+
+struct CookedModelHeader {
+    uint32_t Magic;
+    uint32_t Version;
+    // NOTE: sizeof(MeshVertex) when cooked, a layout change makes the file stale
+    uint32_t VertexStride;
+    uint32_t MeshCount;
+    uint32_t MaterialCount;
+    uint32_t VertexOffset;
+    uint32_t VertexSize;
+    uint32_t IndexOffset;
+    uint32_t IndexSize;
+};
+
+struct CookedModelMesh {
+    // NOTE: In vertices and indices from the start of their blob. Indices
+    // are local to the mesh, FirstVertex is added when drawing
+    uint32_t FirstVertex;
+    uint32_t VertexCount;
+    uint32_t FirstIndex;
+    uint32_t IndexCount;
+    uint32_t Material;
+    float BoundsMin[3];
+    float BoundsMax[3];
+};
+
+struct CookedModelMaterial {
+    char Name[COOKED_MODEL_NAME_LENGTH];
+    // NOTE: Relative to the model's directory, empty if it has none
+    char DiffusePath[COOKED_MODEL_PATH_LENGTH];
+};
+
+/**
+ * @brief Validated view into a cooked model held in memory
+ */
+struct CookedModel {
+    const CookedModelHeader* Header;
+    const CookedModelMesh* Meshes;
+    const CookedModelMaterial* Materials;
+    const unsigned char* Vertices;
+    const unsigned char* Indices;
+};
+
+/**
+ * @brief Checks header, tables and bounds of a cooked model
+ *
+ * @param data File contents
+ * @param size Size in bytes
+ * @param model Output view, points into data
+ *
+ * @returns true - Valid, false - Corrupt, unsupported version or vertex layout
+ */
+bool ParseCookedModel(const unsigned char* data, size_t size, CookedModel* model);
+
+/**
+ * @brief Where the cooker writes the cooked version of a source model,
+ * e.g. resources/rug/rug.obj -> cooked/resources/rug/rug.cmdl
+ *
+ * @param sourcePath Source model path, relative to the working directory
+ *
+ * @returns Cooked model path
+ */
+std::string GetCookedModelPath(const std::string& sourcePath);
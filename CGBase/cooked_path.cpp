@@ -0,0 +1,32 @@
+#include "cooked_path.hpp"
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
+
+std::string
+GetCookedPath(const std::string& sourcePath, const std::string& extension) {
+    size_t Dot = sourcePath.find_last_of('.');
+    size_t Slash = sourcePath.find_last_of("/\\");
+    std::string Stem = Dot != std::string::npos && (Slash == std::string::npos || Dot > Slash)
+        ? sourcePath.substr(0, Dot)
+        : sourcePath;
+    return COOKED_PATH + Stem + extension;
+}
+
+std::vector<std::string>
+FindFilesWithExtensions(const std::string& directory, const std::vector<std::string>& extensions) {
+    std::vector<std::string> Paths;
+    std::error_code Error;
+    for (const auto& Entry : std::filesystem::recursive_directory_iterator(directory, Error)) {
+        if (!Entry.is_regular_file()) {
+            continue;
+        }
+
+        std::string Extension = Entry.path().extension().string();
+        std::transform(Extension.begin(), Extension.end(), Extension.begin(), [](unsigned char C) { return (char)std::tolower(C); });
+        if (std::find(extensions.begin(), extensions.end(), Extension) != extensions.end()) {
+            Paths.push_back(Entry.path().generic_string());
+        }
+    }
+    return Paths;
+}
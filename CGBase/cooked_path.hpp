@@ -0,0 +1,34 @@
+/**
+ * @file cooked_path.hpp
+ * @brief Where the cooker puts cooked assets, and how it finds their
+ * sources, shared by every cooked format
+ *
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+
+static const std::string COOKED_PATH = "cooked/";
+
+/**
+ * @brief Mirrors a source asset path under COOKED_PATH with the extension
+ * replaced, e.g. resources/Moon_Diffuse.jpg -> cooked/resources/Moon_Diffuse.ctex
+ *
+ * @param sourcePath Source asset path, relative to the working directory
+ * @param extension Extension of the cooked format, with the dot
+ *
+ * @returns Cooked asset path
+ */
+std::string GetCookedPath(const std::string& sourcePath, const std::string& extension);
+
+/**
+ * @brief Lists regular files under a directory and its subdirectories
+ * whose extension matches one of extensions, ignoring case
+ *
+ * @param directory Directory to search, a missing one lists nothing
+ * @param extensions Lowercase extensions, with the dot
+ *
+ * @returns Paths with forward slashes, in directory iteration order
+ */
+std::vector<std::string> FindFilesWithExtensions(const std::string& directory, const std::vector<std::string>& extensions);
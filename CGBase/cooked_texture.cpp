@@ -0,0 +1,53 @@
+#include "cooked_texture.hpp"
+
+size_t
+CookedTexture::GetBytes(unsigned firstMip) const {
+    size_t Bytes = 0;
+    for (uint32_t MipIdx = firstMip; MipIdx < Header->MipCount; ++MipIdx) {
+        Bytes += Mips[MipIdx].Size;
+    }
+    return Bytes;
+}
+
+size_t
+CookedTexture::GetChainBytes(unsigned firstMip, unsigned lastMip) const {
+    return (size_t)Mips[lastMip].Offset + Mips[lastMip].Size - Mips[firstMip].Offset;
+}
+
+bool
+ParseCookedTexture(const unsigned char* data, size_t size, CookedTexture* texture) {
+    if (size < sizeof(CookedTextureHeader)) {
+        return false;
+    }
+
+    const CookedTextureHeader* Header = (const CookedTextureHeader*)data;
+    if (Header->Magic != COOKED_TEXTURE_MAGIC || Header->Version != COOKED_TEXTURE_VERSION
+        || !Header->MipCount || Header->MipCount > COOKED_TEXTURE_MAX_MIPS) {
+        return false;
+    }
+
+    size_t TableEnd = sizeof(CookedTextureHeader) + Header->MipCount * sizeof(CookedTextureMip);
+    if (size < TableEnd) {
+        return false;
+    }
+
+    const CookedTextureMip* Mips = (const CookedTextureMip*)(data + sizeof(CookedTextureHeader));
+    // NOTE: Mips must follow each other in order, uploads copy the chain in one go
+    size_t PreviousEnd = TableEnd;
+    for (uint32_t MipIdx = 0; MipIdx < Header->MipCount; ++MipIdx) {
+        if (Mips[MipIdx].Offset < PreviousEnd || (size_t)Mips[MipIdx].Offset + Mips[MipIdx].Size > size) {
+            return false;
+        }
+        PreviousEnd = (size_t)Mips[MipIdx].Offset + Mips[MipIdx].Size;
+    }
+
+    texture->Header = Header;
+    texture->Mips = Mips;
+    texture->Data = data;
+    return true;
+}
+
+std::string
+GetCookedTexturePath(const std::string& sourcePath) {
+    return GetCookedPath(sourcePath, COOKED_TEXTURE_EXTENSION);
+}
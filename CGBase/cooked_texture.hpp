@@ -0,0 +1,78 @@
+/**
+ * @file cooked_texture.hpp
+ * @brief Cooked texture container: every mip level pre-built and block
+ * compressed, stored so it can be handed to GL as is
+ *
+ */
+
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "cooked_path.hpp"
+
+static const std::string COOKED_TEXTURE_EXTENSION = ".ctex";
+static const uint32_t COOKED_TEXTURE_MAGIC = 0x58455443; // "CTEX"
+static const uint32_t COOKED_TEXTURE_VERSION = 1;
+static const unsigned COOKED_TEXTURE_MAX_MIPS = 16;
+// NOTE: Every mip starts on this boundary so it can be uploaded straight from the file
+static const unsigned COOKED_TEXTURE_MIP_ALIGNMENT = 256;
+
+struct CookedTextureHeader {
+    uint32_t Magic;
+    uint32_t Version;
+    // NOTE: GL internal format, one of the S3TC compressed formats
+    uint32_t Format;
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t MipCount;
+};
+
+struct CookedTextureMip {
+    uint32_t Offset;
+    uint32_t Size;
+    uint32_t Width;
+    uint32_t Height;
+};
+
+/**
+ * @brief Validated view into a cooked texture held in memory
+ */
+struct CookedTexture {
+    const CookedTextureHeader* Header;
+    const CookedTextureMip* Mips;
+    const unsigned char* Data;
+
+    /**
+     * @brief Sum of the sizes of firstMip and every coarser mip, what the
+     * texture occupies on the GPU with those mips resident
+     */
+    size_t GetBytes(unsigned firstMip = 0) const;
+
+    /**
+     * @brief Span from the start of firstMip to the end of lastMip,
+     * alignment padding included
+     */
+    size_t GetChainBytes(unsigned firstMip, unsigned lastMip) const;
+};
+
+/**
+ * @brief Checks header, mip table and bounds of a cooked texture
+ *
+ * @param data File contents
+ * @param size Size in bytes
+ * @param texture Output view, points into data
+ *
+ * @returns true - Valid, false - Corrupt or unsupported version
+ */
+bool ParseCookedTexture(const unsigned char* data, size_t size, CookedTexture* texture);
+
+/**
+ * @brief Where the cooker writes the cooked version of a source image,
+ * e.g. resources/Moon_Diffuse.jpg -> cooked/resources/Moon_Diffuse.ctex
+ *
+ * @param sourcePath Source image path, relative to the working directory
+ *
+ * @returns Cooked texture path
+ */
+std::string GetCookedTexturePath(const std::string& sourcePath);
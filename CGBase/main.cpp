@@ -2,20 +2,81 @@
 #include <GLFW/glfw3.h>
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <chrono>
 #include <thread>
+#include <filesystem>
+#include <atomic>
+#include <new>
 #include "shader.hpp"
+#include "shader_variants.hpp"
+#include "shader_watcher.hpp"
+#include "program_cache.hpp"
 #include "camera.hpp"
 #include "model.hpp"
 #include "texture.hpp"
+#include "texture_loader.hpp"
+#include "texture_cache.hpp"
+#include "thread_pool.hpp"
+#include "texture_cooker.hpp"
+#include "model_cooker.hpp"
+#include "texture_array.hpp"
+#include "texture_decoder.hpp"
+#include "mapped_file.hpp"
 #include "renderable.hpp"
+#include "scene_uniforms.hpp"
+#include "vertex_format.hpp"
+
+
+// NOTE: Define COUNT_ALLOCATIONS for --bench-load to count heap allocations
+// made through the global operator new. Replacing it is process wide, so
+// it's left out of regular builds
+#ifdef COUNT_ALLOCATIONS
+static const bool COUNTS_ALLOCATIONS = true;
+static std::atomic<size_t> sAllocationCount(0);
+
+void*
+operator new(size_t size) {
+    sAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* Memory = std::malloc(size ? size : 1)) {
+        return Memory;
+    }
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void
+operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
 
+static size_t
+GetAllocationCount() {
+    return sAllocationCount.load();
+}
+#else
+static const bool COUNTS_ALLOCATIONS = false;
+
+static size_t
+GetAllocationCount() {
+    return 0;
+}
+#endif
 
 int WindowWidth = 1280;
 int WindowHeight = 720;
 const float TargetFPS = 60.0f;
+const float FieldOfViewY = 45.0f;
+// NOTE: Cube and pyramid vertices below are written out as MeshVertexFormat
+const unsigned MESH_VERTEX_FLOATS = MeshVertexFormat::STRIDE / sizeof(float);
 const std::string WindowTitle = "Egypt world";
 const int steps = 360;
 const float moonAngle = 3.1415926 * 2.f / steps;
@@ -47,6 +108,88 @@ struct EngineState {
     float mDT;
 };
 
+// NOTE: Objects smaller than this on screen switch to Gouraud, larger than
+// LOD_PHONG_ABOVE_PX switch back. The gap keeps objects from flickering
+// between the two when they hover around one threshold
+static const float LOD_GOURAUD_BELOW_PX = 48.0f;
+static const float LOD_PHONG_ABOVE_PX = 64.0f;
+
+// NOTE: Picks the cheapest shader that still lights an object the same.
+// Phong vs Gouraud by projected size, then the permutation by which lights reach it
+struct ShadingSelector {
+    ShaderVariants* mVariants;
+    ShaderVariants* mGouraudVariants;
+    const LightBlock* mLights;
+    // NOTE: Indexed by [diffuse is a texture array layer][compact vertices][point lights lit][spotlight reaches object]
+    ShaderDefines mDefines[2][2][2][2];
+    bool mPointLightsLit;
+    bool mShadingLod;
+    glm::vec3 mViewPos;
+    // NOTE: Pixels per world unit at distance 1, WindowHeight / (2 * tan(fov / 2))
+    float mPixelsPerUnit;
+    // NOTE: Per draw, in draw order, whether it was Gouraud shaded last frame
+    std::vector<bool> mGouraud;
+    unsigned mDrawIdx;
+    unsigned mGouraudCount;
+    // NOTE: Told each draw's on-screen size so streaming refines what's
+    // largest first, may be null
+    TextureLoader* mTextureLoader;
+    // NOTE: Texture array on unit 0, draws sharing it skip the bind
+    unsigned mBoundArray;
+};
+
+static void
+BeginShadingFrame(ShadingSelector* selector, const glm::vec3& viewPos, float fovY) {
+    selector->mViewPos = viewPos;
+    selector->mPixelsPerUnit = WindowHeight / (2.0f * std::tan(fovY * 0.5f));
+    selector->mDrawIdx = 0;
+    selector->mGouraudCount = 0;
+    selector->mBoundArray = 0;
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+// NOTE: Layer goes in as a constant vertex attribute, the same input an
+// instance buffer would feed, so instanced draws need no shader changes
+static void
+BindLayer(ShadingSelector* selector, const TextureLayer& layer) {
+    if (selector->mBoundArray != layer.Array) {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, layer.Array);
+        selector->mBoundArray = layer.Array;
+    }
+    glVertexAttrib1f(LayerAttribute::LOCATION, (float)layer.Layer);
+}
+
+static Shader&
+SelectShader(ShadingSelector* selector, const glm::vec3& center, float radius, unsigned diffuse, bool textureArray = false,
+    bool compactVertices = false) {
+    unsigned DrawIdx = selector->mDrawIdx++;
+    if (DrawIdx >= selector->mGouraud.size()) {
+        selector->mGouraud.resize(DrawIdx + 1, false);
+    }
+
+    float Distance = glm::length(center - selector->mViewPos);
+    // NOTE: Camera inside the bounds counts as infinitely large
+    float ScreenRadius = Distance > radius ? radius * selector->mPixelsPerUnit / Distance : 1e9f;
+    if (selector->mTextureLoader && !textureArray) {
+        selector->mTextureLoader->RequestResolution(diffuse, 2.0f * ScreenRadius);
+    }
+
+    bool Gouraud = false;
+    if (selector->mShadingLod) {
+        Gouraud = selector->mGouraud[DrawIdx]
+            ? ScreenRadius <= LOD_PHONG_ABOVE_PX
+            : ScreenRadius < LOD_GOURAUD_BELOW_PX;
+    }
+    selector->mGouraud[DrawIdx] = Gouraud;
+    selector->mGouraudCount += Gouraud;
+
+    bool SpotlightLit = SpotlightReachesSphere(selector->mLights->Spotlight, center, radius);
+    ShaderVariants* Variants = Gouraud ? selector->mGouraudVariants : selector->mVariants;
+    return Variants->Get(selector->mDefines[textureArray][compactVertices][selector->mPointLightsLit][SpotlightLit]);
+}
+
 static void
 ErrorCallback(int error, const char* description) {
     std::cerr << "GLFW Error: " << description << std::endl;
@@ -91,7 +234,7 @@ FramebufferSizeCallback(GLFWwindow* window, int width, int height) {
 }
 
 static void
-HandleInput(EngineState* state, const Shader& shader) {
+HandleInput(EngineState* state, LightData& spotlight) {
     Input* UserInput = state->mInput;
     Camera* FPSCamera = state->mCamera;
     if (UserInput->MoveLeft) FPSCamera->Move(-1.0f, 0.0f, state->mDT);
@@ -106,56 +249,50 @@ HandleInput(EngineState* state, const Shader& shader) {
 
     if (UserInput->RugLeft)
     {
-        glUseProgram(shader.GetId());
         x += 0.25;
         spotlightX += 1.00;
-        shader.SetUniform3f("uSpotlight.Direction", glm::vec3(spotlightX, spotlightY, spotlightZ));
-        glUseProgram(0);
+        spotlight.Direction = glm::vec3(spotlightX, spotlightY, spotlightZ);
     }
     if (UserInput->RugRight)
     {
-        glUseProgram(shader.GetId());
         x -= 0.25;
         spotlightX -= 1.0;
-        shader.SetUniform3f("uSpotlight.Direction", glm::vec3(spotlightX, spotlightY, spotlightZ));
-        glUseProgram(0);
+        spotlight.Direction = glm::vec3(spotlightX, spotlightY, spotlightZ);
     }
     if (UserInput->RugDown)
     {
-        glUseProgram(shader.GetId());
         y -= 0.25;
         spotlightY -= 0.25;
         if (y < -3.5)
             y = -3.5;
         else
-            shader.SetUniform3f("uSpotlight.Direction", glm::vec3(spotlightX, spotlightY, spotlightZ));
-        glUseProgram(0);
+            spotlight.Direction = glm::vec3(spotlightX, spotlightY, spotlightZ);
     }
     if (UserInput->RugUp)
     {
-        glUseProgram(shader.GetId());
         y += 0.25;
         spotlightY -= 0.25;
         if (y > 13)
             y = 13;
         else
-            shader.SetUniform3f("uSpotlight.Direction", glm::vec3(spotlightX, spotlightY, spotlightZ));
-        glUseProgram(0);
+            spotlight.Direction = glm::vec3(spotlightX, spotlightY, spotlightZ);
     }
 }
 
 static void
-DrawFloor(unsigned vao, const Shader& shader, unsigned diffuse) {
+DrawFloor(unsigned vao, ShadingSelector* selector, const TextureLayer& diffuse) {
+    float Size = 4.0f;
+    glm::vec3 Position(2.0, -2.0f, 2.0);
+    glm::vec3 Scale(50 * Size, 0.1f, 50 * Size);
+    const Shader& shader = SelectShader(selector, Position, glm::length(Scale) * 0.5f, 0, true);
     glUseProgram(shader.GetId());
     glBindVertexArray(vao);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, diffuse);
-    float Size = 4.0f;
+    BindLayer(selector, diffuse);
     for (int i = -2; i < 4; ++i) {
         for (int j = -2; j < 4; ++j) {
             glm::mat4 Model(1.0f);
-            Model = glm::translate(Model, glm::vec3(2.0, -2.0f, 2.0));
-            Model = glm::scale(Model, glm::vec3(50 * Size, 0.1f, 50 * Size));
+            Model = glm::translate(Model, Position);
+            Model = glm::scale(Model, Scale);
             shader.SetModel(Model);
             glDrawArrays(GL_TRIANGLES, 0, 36);
         }
@@ -166,15 +303,17 @@ DrawFloor(unsigned vao, const Shader& shader, unsigned diffuse) {
 }
 
 static void
-DrawMoon(unsigned vao, const Shader& shader, unsigned diffuse) {
+DrawMoon(unsigned vao, ShadingSelector* selector, const TextureLayer& diffuse) {
+    glm::vec3 Position(-5.0, 30.5, -30.0);
+    // NOTE: Rotations keep the cube inside the sphere around its corners
+    const Shader& shader = SelectShader(selector, Position, glm::length(glm::vec3(5.0f)) * 0.5f, 0, true);
     glUseProgram(shader.GetId());
     glBindVertexArray(vao);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, diffuse);
+    BindLayer(selector, diffuse);
     float moonAngleRotate = 0.0;
     for (int i = 0; i < steps; i++) {
         glm::mat4 Model(1.0f);
-        Model = glm::translate(glm::mat4(1.0f), glm::vec3(-5.0, 30.5, -30.0));
+        Model = glm::translate(glm::mat4(1.0f), Position);
         Model = glm::scale(Model, glm::vec3(5, 5, 5));
         Model = glm::rotate(Model, glm::radians(moonAngleRotate), glm::vec3(1.0, 0.0, 0.0));
         Model = glm::rotate(Model, glm::radians(moonAngleRotate), glm::vec3(1.0, 1.0, 0.0));
@@ -188,11 +327,14 @@ DrawMoon(unsigned vao, const Shader& shader, unsigned diffuse) {
 }
 
 static void
-DrawPyramid(unsigned vao, const Shader& shader, glm::vec3 position, glm::vec3 scale, unsigned diffuse) {
+DrawPyramid(unsigned vao, ShadingSelector* selector, glm::vec3 position, glm::vec3 scale, const TextureLayer& diffuse) {
+    // NOTE: Pyramid spans [-0.5, 0.5] x [0, 0.6] x [-0.5, 0.5] in model space
+    glm::vec3 Center = position + glm::vec3(0.0f, 0.3f * scale.y, 0.0f);
+    float Radius = glm::length(scale * glm::vec3(1.0f, 0.6f, 1.0f)) * 0.5f;
+    const Shader& shader = SelectShader(selector, Center, Radius, 0, true);
     glUseProgram(shader.GetId());
     glBindVertexArray(vao);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, diffuse);
+    BindLayer(selector, diffuse);
     glm::mat4 ModelMatrix(1.0f);
     ModelMatrix = glm::translate(ModelMatrix, position);
     ModelMatrix = glm::scale(ModelMatrix, scale);
@@ -203,7 +345,9 @@ DrawPyramid(unsigned vao, const Shader& shader, glm::vec3 position, glm::vec3 sc
 }
 
 static void
-DrawStone(const Shader& shader, glm::vec3 position, glm::vec3 scale) {
+DrawStone(ShadingSelector* selector, glm::vec3 position, glm::vec3 scale) {
+    const Shader& shader = SelectShader(selector, position, glm::length(scale) * 0.5f, 0, true);
+    glUseProgram(shader.GetId());
     glm::mat4 ModelMatrix(1.0f);
     ModelMatrix = glm::mat4(1.0f);
     ModelMatrix = glm::translate(ModelMatrix, position);
@@ -213,31 +357,593 @@ DrawStone(const Shader& shader, glm::vec3 position, glm::vec3 scale) {
 }
 
 static void
-DrawStones(unsigned vao, const Shader& shader, unsigned diffuse) {
-    glUseProgram(shader.GetId());
+DrawStones(unsigned vao, ShadingSelector* selector, const TextureLayer& diffuse) {
     glBindVertexArray(vao);
+    BindLayer(selector, diffuse);
+
+    DrawStone(selector, glm::vec3(5.1f, -2.5f, 14.0f), glm::vec3(1.5f));
+    DrawStone(selector, glm::vec3(10.1f, -2.5f, 3.0f), glm::vec3(1.5f));
+    DrawStone(selector, glm::vec3(-51.1f, -2.5f, -13.0f), glm::vec3(1.5f));
+    DrawStone(selector, glm::vec3(-10.1f, -2.5f, -3.0f), glm::vec3(1.5f));
+    DrawStone(selector, glm::vec3(15.1f, -2.5f, 34.0f), glm::vec3(1.5f));
+    DrawStone(selector, glm::vec3(1.1f, -2.5f, -23.0f), glm::vec3(1.5f));
+
+    DrawStone(selector, glm::vec3(16.1f, -2.5f, -14.0f), glm::vec3(1.5f));
+    DrawStone(selector, glm::vec3(50.1f, -2.5f, -3.0f), glm::vec3(1.5f));
+    DrawStone(selector, glm::vec3(-31.1f, -2.5f, 13.0f), glm::vec3(1.5f));
+    DrawStone(selector, glm::vec3(-13.1f, -2.5f, 3.0f), glm::vec3(1.5f));
+    DrawStone(selector, glm::vec3(46.1f, -2.5f, -34.0f), glm::vec3(1.5f));
+    DrawStone(selector, glm::vec3(2.1f, -2.5f, 23.0f), glm::vec3(1.5f));
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+static void
+DrawModel(Model& model, ShadingSelector* selector, const glm::mat4& modelMatrix, float scale, unsigned diffuse) {
+    glm::vec3 Center = glm::vec3(modelMatrix * glm::vec4(model.GetBoundsCenter(), 1.0f));
+    const Shader& shader = SelectShader(selector, Center, model.GetBoundsRadius() * scale, diffuse, false,
+        model.GetPrecision() == VERTEX_PRECISION_COMPACT);
+    glUseProgram(shader.GetId());
+    shader.SetModel(modelMatrix);
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, diffuse);
+    model.Render(shader);
+}
 
-    DrawStone(shader, glm::vec3(5.1f, -2.5f, 14.0f), glm::vec3(1.5f));
-    DrawStone(shader, glm::vec3(10.1f, -2.5f, 3.0f), glm::vec3(1.5f));
-    DrawStone(shader, glm::vec3(-51.1f, -2.5f, -13.0f), glm::vec3(1.5f));
-    DrawStone(shader, glm::vec3(-10.1f, -2.5f, -3.0f), glm::vec3(1.5f));
-    DrawStone(shader, glm::vec3(15.1f, -2.5f, 34.0f), glm::vec3(1.5f));
-    DrawStone(shader, glm::vec3(1.1f, -2.5f, -23.0f), glm::vec3(1.5f));
+static void
+InitPhongMaterial(const Shader& shader) {
+    shader.SetUniform1i("uMaterial.Kd", 0);
+    shader.SetUniform1i("uMaterial.Ks", 1);
+    shader.SetUniform1f("uMaterial.Shininess", 128.0f);
+    shader.SetUniform1f("uShininess", 128.0f);
+}
 
-    DrawStone(shader, glm::vec3(16.1f, -2.5f, -14.0f), glm::vec3(1.5f));
-    DrawStone(shader, glm::vec3(50.1f, -2.5f, -3.0f), glm::vec3(1.5f));
-    DrawStone(shader, glm::vec3(-31.1f, -2.5f, 13.0f), glm::vec3(1.5f));
-    DrawStone(shader, glm::vec3(-13.1f, -2.5f, 3.0f), glm::vec3(1.5f));
-    DrawStone(shader, glm::vec3(46.1f, -2.5f, -34.0f), glm::vec3(1.5f));
-    DrawStone(shader, glm::vec3(2.1f, -2.5f, 23.0f), glm::vec3(1.5f));
+// NOTE: Everything drawn with the phong shader
+struct SceneObjects {
+    unsigned CubeVAO;
+    unsigned PyramidVAO;
+    Model* Rug;
+    Model* Egy;
+    // NOTE: Layers of shared texture arrays, drawn with one bind when they all fit one
+    TextureLayer FloorDiffuse;
+    TextureLayer MoonDiffuse;
+    TextureLayer PyramidDiffuse;
+    TextureLayer StoneDiffuse;
+    TextureHandle RugDiffuse;
+    TextureHandle EgyDiffuse;
+};
 
-    glBindVertexArray(0);
+static void
+DrawLitObjects(ShadingSelector* selector, const SceneObjects& objects, double rugBob) {
+    glm::mat4 ModelMatrix(1.0f);
+    ModelMatrix = glm::translate(ModelMatrix, glm::vec3(0.5, 2.7 + rugBob, +0.5));
+    ModelMatrix = glm::translate(ModelMatrix, glm::vec3(x, y, z));
+    ModelMatrix = glm::scale(ModelMatrix, glm::vec3(7.0f, 7.0f, 7.0f));
+    DrawModel(*objects.Rug, selector, ModelMatrix, 7.0f, objects.RugDiffuse.GetId());
+
+    ModelMatrix = glm::mat4(1.0f);
+    ModelMatrix = glm::translate(ModelMatrix, glm::vec3(-38.0f, -1.0f, -38.0f));
+    DrawModel(*objects.Egy, selector, ModelMatrix, 1.0f, objects.EgyDiffuse.GetId());
+
+    ModelMatrix = glm::mat4(1.0f);
+    ModelMatrix = glm::translate(ModelMatrix, glm::vec3(13.0f, -1.0f, 42.0f));
+    DrawModel(*objects.Egy, selector, ModelMatrix, 1.0f, objects.EgyDiffuse.GetId());
+
+    ModelMatrix = glm::mat4(1.0f);
+    ModelMatrix = glm::translate(ModelMatrix, glm::vec3(53.0f, -1.0f, 10.0f));
+    DrawModel(*objects.Egy, selector, ModelMatrix, 1.0f, objects.EgyDiffuse.GetId());
+
+    DrawFloor(objects.CubeVAO, selector, objects.FloorDiffuse);
+    DrawMoon(objects.CubeVAO, selector, objects.MoonDiffuse);
+    DrawPyramid(objects.PyramidVAO, selector, glm::vec3(65.0, -5.0, 0.0), glm::vec3(25.0, 25.0, 25.0), objects.PyramidDiffuse);
+    DrawPyramid(objects.PyramidVAO, selector, glm::vec3(-35.0, -5.0, -50.0), glm::vec3(25.0, 25.0, 25.0), objects.PyramidDiffuse);
+    DrawPyramid(objects.PyramidVAO, selector, glm::vec3(5.0, -5.0, 30.0), glm::vec3(25.0, 25.0, 25.0), objects.PyramidDiffuse);
+    DrawStones(objects.CubeVAO, selector, objects.StoneDiffuse);
+}
+
+/**
+ * @brief Renders the lit objects with the current phong shader and with
+ * the baseline kernel in shaders/reference/phong_material_texture.frag,
+ * then compares the frames pixel by pixel. Runs once with the variants the
+ * scene uses (no specular map) and once with HAS_SPECULAR_MAP=1 and a
+ * specular map bound. Skipped lights may each shift a channel by one
+ * 8-bit step, anything more is a failure
+ *
+ * @param selector Phong variants in use, lights must already be uploaded
+ * @param objects Objects to draw
+ *
+ * @returns 0 - Match, 1 - Mismatch
+ */
+static int
+RunGoldenComparison(ShadingSelector* selector, const SceneObjects& objects) {
+    const int Tolerance = MAX_POINT_LIGHTS + 1;
+
+    ShaderVariants ReferenceVariants("shaders/basic.vert", "shaders/reference/phong_material_texture.frag", InitPhongMaterial);
+    unsigned SpecularMap = Texture::LoadImageToTexture("resources/Stone_Specular.jpg");
+
+    auto Render = [&](ShadingSelector* current, std::vector<unsigned char>& pixels) {
+        // NOTE: First pass compiles every variant it needs, time the second
+        for (int PassIdx = 0; PassIdx < 2; ++PassIdx) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            BeginShadingFrame(current, current->mViewPos, FieldOfViewY);
+            DrawLitObjects(current, objects, 0.0);
+            glFinish();
+        }
+        double Start = glfwGetTime();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        BeginShadingFrame(current, current->mViewPos, FieldOfViewY);
+        DrawLitObjects(current, objects, 0.0);
+        glFinish();
+        double Elapsed = glfwGetTime() - Start;
+
+        pixels.resize((size_t)WindowWidth * WindowHeight * 4);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, WindowWidth, WindowHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        return Elapsed * 1000.0;
+    };
+
+    std::cout << "Golden image comparison, " << WindowWidth << "x" << WindowHeight << std::endl;
+    size_t TotalFailedPixels = 0;
+    for (int HasSpecularMap = 0; HasSpecularMap < 2; ++HasSpecularMap) {
+        // NOTE: Compare the phong kernels alone, Gouraud LOD would differ by design
+        ShadingSelector CurrentSelector = *selector;
+        CurrentSelector.mShadingLod = false;
+        ShaderDefines* Defines = &CurrentSelector.mDefines[0][0][0][0];
+        for (size_t DefinesIdx = 0; DefinesIdx < sizeof(CurrentSelector.mDefines) / sizeof(ShaderDefines); ++DefinesIdx) {
+            Defines[DefinesIdx].Set("HAS_SPECULAR_MAP", HasSpecularMap);
+        }
+        ShadingSelector ReferenceSelector = CurrentSelector;
+        ReferenceSelector.mVariants = &ReferenceVariants;
+
+        // NOTE: Unit 1 is otherwise left empty, so the reference samples black
+        // specular exactly when the current kernel compiles specular out
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, HasSpecularMap ? SpecularMap : 0);
+
+        std::vector<unsigned char> Current;
+        std::vector<unsigned char> Reference;
+        double CurrentTime = Render(&CurrentSelector, Current);
+        double ReferenceTime = Render(&ReferenceSelector, Reference);
+
+        int MaxDifference = 0;
+        size_t DifferentPixels = 0;
+        size_t FailedPixels = 0;
+        for (size_t PixelIdx = 0; PixelIdx < Current.size(); PixelIdx += 4) {
+            int PixelDifference = 0;
+            for (int Channel = 0; Channel < 3; ++Channel) {
+                PixelDifference = std::max(PixelDifference, std::abs(Current[PixelIdx + Channel] - Reference[PixelIdx + Channel]));
+            }
+            MaxDifference = std::max(MaxDifference, PixelDifference);
+            DifferentPixels += PixelDifference > 0;
+            FailedPixels += PixelDifference > Tolerance;
+        }
+        TotalFailedPixels += FailedPixels;
+
+        std::cout << "  HAS_SPECULAR_MAP=" << HasSpecularMap << std::endl;
+        std::cout << "    reference: " << ReferenceTime << " ms, current: " << CurrentTime << " ms" << std::endl;
+        std::cout << "    pixels differing: " << DifferentPixels << ", max difference: " << MaxDifference
+            << ", over tolerance (" << Tolerance << "): " << FailedPixels << std::endl;
+    }
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glDeleteTextures(1, &SpecularMap);
+    std::cout << (TotalFailedPixels ? "FAIL" : "PASS") << std::endl;
+    return TotalFailedPixels ? 1 : 0;
+}
+
+/**
+ * @brief Renders the lit objects from the current camera with shading LOD
+ * off and on, and reports the average frame time of each
+ *
+ * @param selector Shader selector, lights and view must already be set up
+ * @param objects Objects to draw
+ */
+static void
+RunShadingLodBenchmark(ShadingSelector* selector, const SceneObjects& objects) {
+    const int FrameCount = 100;
+
+    auto Measure = [&](bool shadingLod) {
+        selector->mShadingLod = shadingLod;
+        selector->mGouraud.clear();
+        // NOTE: Warm up so every variant used is compiled before timing
+        BeginShadingFrame(selector, selector->mViewPos, FieldOfViewY);
+        DrawLitObjects(selector, objects, 0.0);
+        glFinish();
+
+        double Start = glfwGetTime();
+        for (int FrameIdx = 0; FrameIdx < FrameCount; ++FrameIdx) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            BeginShadingFrame(selector, selector->mViewPos, FieldOfViewY);
+            DrawLitObjects(selector, objects, 0.0);
+        }
+        glFinish();
+        return (glfwGetTime() - Start) * 1000.0 / FrameCount;
+    };
+
+    double PhongTime = Measure(false);
+    double LodTime = Measure(true);
+    std::cout << "Shading LOD, " << WindowWidth << "x" << WindowHeight << ", " << FrameCount << " frames" << std::endl;
+    std::cout << "  all phong:   " << PhongTime << " ms/frame" << std::endl;
+    std::cout << "  shading LOD: " << LodTime << " ms/frame, " << selector->mGouraudCount << " of "
+        << selector->mDrawIdx << " draws Gouraud shaded" << std::endl;
+    std::cout << "  saved " << (PhongTime - LodTime) << " ms/frame (" << (1.0 - LodTime / PhongTime) * 100.0 << "%)" << std::endl;
+}
+
+/**
+ * @brief Measures vertex throughput of basic.vert with the normal matrix
+ * computed per vertex versus uploaded per draw. Rasterizes into a 1x1
+ * viewport with lighting compiled out, so the vertex stage dominates
+ *
+ * @param model Model to draw
+ */
+static void
+RunVertexBenchmark(Model& model) {
+    const int DrawCount = 200;
+    const int Repeats = 5;
+
+    ShaderDefines Defines;
+    Defines.Set("NUM_POINT_LIGHTS", 0).Set("HAS_SPOTLIGHT", 0).Set("HAS_SPECULAR_MAP", 0)
+        .Set("COMPACT_VERTICES", model.GetPrecision() == VERTEX_PRECISION_COMPACT);
+    Shader PerVertex("shaders/basic.vert", "shaders/phong_material_texture.frag", ShaderDefines(Defines).Set("PER_VERTEX_NORMAL_MATRIX", 1));
+    Shader PerDraw("shaders/basic.vert", "shaders/phong_material_texture.frag", ShaderDefines(Defines).Set("PER_VERTEX_NORMAL_MATRIX", 0));
+
+    std::vector<glm::mat4> UniformScaled(DrawCount);
+    std::vector<glm::mat4> NonUniformScaled(DrawCount);
+    for (int DrawIdx = 0; DrawIdx < DrawCount; ++DrawIdx) {
+        glm::mat4 Rotated = glm::rotate(glm::mat4(1.0f), glm::radians((float)DrawIdx), glm::vec3(0.0f, 1.0f, 0.0f));
+        UniformScaled[DrawIdx] = glm::scale(Rotated, glm::vec3(1.5f));
+        NonUniformScaled[DrawIdx] = glm::scale(Rotated, glm::vec3(1.0f, 2.0f, 0.5f));
+    }
+
+    glViewport(0, 0, 1, 1);
+    double VertexCount = (double)model.GetDrawnVertexCount() * DrawCount * Repeats;
+    auto Measure = [&](const Shader& shader, const std::vector<glm::mat4>& matrices) {
+        glUseProgram(shader.GetId());
+        // NOTE: Warm up so the driver finishes any lazy compilation first
+        shader.SetModel(matrices[0]);
+        model.Render(shader);
+        glFinish();
+
+        double Start = glfwGetTime();
+        for (int RepeatIdx = 0; RepeatIdx < Repeats; ++RepeatIdx) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            for (const glm::mat4& Matrix : matrices) {
+                shader.SetModel(Matrix);
+                model.Render(shader);
+            }
+        }
+        glFinish();
+        return VertexCount / (glfwGetTime() - Start) / 1e6;
+    };
+
+    std::cout << "Vertex throughput, " << model.mFilename << " x " << DrawCount << " draws x " << Repeats << " repeats" << std::endl;
+    std::cout << "  per-vertex inverse, uniform scale:     " << Measure(PerVertex, UniformScaled) << " Mverts/s" << std::endl;
+    std::cout << "  per-vertex inverse, non-uniform scale: " << Measure(PerVertex, NonUniformScaled) << " Mverts/s" << std::endl;
+    std::cout << "  uNormalMatrix, uniform scale:          " << Measure(PerDraw, UniformScaled) << " Mverts/s" << std::endl;
+    std::cout << "  uNormalMatrix, non-uniform scale:      " << Measure(PerDraw, NonUniformScaled) << " Mverts/s" << std::endl;
+
+    const int MatrixCount = 1000000;
+    // NOTE: Keeps the optimizer from dropping the loop
+    volatile float Sink = 0.0f;
+    auto MeasureCpu = [&](const glm::mat4& matrix) {
+        auto Start = std::chrono::steady_clock::now();
+        for (int MatrixIdx = 0; MatrixIdx < MatrixCount; ++MatrixIdx) {
+            Sink = Sink + GetNormalMatrix(matrix)[0][0];
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count() / MatrixCount;
+    };
+    std::cout << "  GetNormalMatrix, uniform scale fast path: " << MeasureCpu(UniformScaled[1]) << " ns" << std::endl;
+    std::cout << "  GetNormalMatrix, full inverse:            " << MeasureCpu(NonUniformScaled[1]) << " ns" << std::endl;
     glUseProgram(0);
 }
 
-int main() {
+/**
+ * @brief Cooks every image and model under resources/ and textures/ into
+ * cooked/, which the texture loader and Model pick up on the next run
+ *
+ * @returns Exit code
+ */
+static int
+RunCook() {
+    const char* const Directories[] = { "resources", "textures" };
+    ThreadPool Workers;
+    TextureCooker Cooker(Workers);
+    auto Start = std::chrono::steady_clock::now();
+    unsigned Cooked = 0;
+    for (const char* Directory : Directories) {
+        Cooked += Cooker.CookDirectory(Directory);
+    }
+    double Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+    size_t Uncompressed = Cooker.GetUncompressedBytes();
+    size_t Compressed = Cooker.GetCookedBytes();
+    std::cout << "Cooked " << Cooked << " textures in " << Elapsed << " s on " << Workers.GetThreadCount() << " threads" << std::endl;
+    if (Compressed) {
+        std::cout << "  GPU memory: " << Uncompressed / (1024.0 * 1024.0) << " MB uncompressed -> " << Compressed / (1024.0 * 1024.0)
+            << " MB cooked (" << (double)Uncompressed / Compressed << "x smaller)" << std::endl;
+    }
+
+    ModelCooker ModelCook;
+    unsigned CookedModels = 0;
+    for (const char* Directory : Directories) {
+        CookedModels += ModelCook.CookDirectory(Directory);
+    }
+    std::cout << "Cooked " << CookedModels << " models, " << ModelCook.GetCookedBytes() / (1024.0 * 1024.0) << " MB" << std::endl;
+    return 0;
+}
+
+/**
+ * @brief Loads each scene model a few times and reports how fast meshes
+ * are ingested into GL buffers and, built with COUNT_ALLOCATIONS, how
+ * many heap allocations it takes.
+ * Assimp's import is timed and counted separately and left out of the
+ * ingestion numbers, which always go through Assimp. Cooked models (see
+ * --cook) are timed as a row of their own. Runs once on a single worker
+ * and once on every worker, to show how mesh processing scales
+ *
+ * @param precision Vertex format models are loaded in
+ */
+static void
+RunLoadBenchmark(VertexPrecision precision) {
+    const char* const Paths[] = { "resources/rug/rug.obj", "resources/anubis/Egy1.obj" };
+    const unsigned ThreadCounts[] = { 1, 0 };
+    const int Repeats = 3;
+
+    std::cout << "Model load benchmark, best of " << Repeats << std::endl;
+    for (unsigned ThreadCount : ThreadCounts) {
+        for (const char* Path : Paths) {
+            ThreadPool Pool(ThreadCount);
+            double BestImport = 1e9;
+            double BestLoad = 1e9;
+            double BestCooked = 1e9;
+            size_t ImportAllocations = 0;
+            size_t LoadAllocations = 0;
+            size_t CookedAllocations = 0;
+            bool HasCooked = std::filesystem::exists(GetCookedModelPath(Path));
+            unsigned Vertices = 0;
+            size_t BufferBytes = 0;
+            for (int RepeatIdx = 0; RepeatIdx < Repeats; ++RepeatIdx) {
+                size_t Allocations = GetAllocationCount();
+                auto Start = std::chrono::steady_clock::now();
+                {
+                    Assimp::Importer Importer;
+                    if (!Importer.ReadFile(Path, POSTPROCESS_FLAGS)) {
+                        std::cerr << "[Err] Failed to import " << Path << std::endl;
+                        break;
+                    }
+                }
+                BestImport = std::min(BestImport, std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count());
+                ImportAllocations = GetAllocationCount() - Allocations;
+
+                {
+                    Model Loaded(Path, precision);
+                    Allocations = GetAllocationCount();
+                    Start = std::chrono::steady_clock::now();
+                    if (!Loaded.Load(Pool, false)) {
+                        break;
+                    }
+                    BestLoad = std::min(BestLoad, std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count());
+                    LoadAllocations = GetAllocationCount() - Allocations;
+                    Vertices = Loaded.GetVertexCount();
+                    BufferBytes = Loaded.GetVertexBytes() + Loaded.GetIndexBytes();
+                }
+
+                if (HasCooked) {
+                    Model Cooked(Path, precision);
+                    Allocations = GetAllocationCount();
+                    Start = std::chrono::steady_clock::now();
+                    // NOTE: A stale or unreadable file falls back to Assimp, that isn't a cooked load
+                    HasCooked = Cooked.Load(Pool) && Cooked.IsCooked();
+                    BestCooked = std::min(BestCooked, std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count());
+                    CookedAllocations = GetAllocationCount() - Allocations;
+                }
+            }
+            if (!Vertices) {
+                continue;
+            }
+
+            double Ingest = std::max(BestLoad - BestImport, 1e-9);
+            std::cout << "  " << Path << ": " << Vertices << " vertices, " << BufferBytes / 1024 << " KB buffers, "
+                << Pool.GetThreadCount() << " threads" << std::endl;
+            std::cout << "    import: " << BestImport * 1000.0 << " ms";
+            if (COUNTS_ALLOCATIONS) {
+                std::cout << ", " << ImportAllocations << " allocations";
+            }
+            std::cout << std::endl << "    ingest: " << Ingest * 1000.0 << " ms, " << Vertices / Ingest / 1e6 << " M vertices/s";
+            if (COUNTS_ALLOCATIONS) {
+                std::cout << ", " << (LoadAllocations > ImportAllocations ? LoadAllocations - ImportAllocations : 0) << " allocations";
+            }
+            std::cout << std::endl;
+            if (HasCooked) {
+                std::cout << "    cooked load: " << BestCooked * 1000.0 << " ms, " << Vertices / BestCooked / 1e6 << " M vertices/s";
+                if (COUNTS_ALLOCATIONS) {
+                    std::cout << ", " << CookedAllocations << " allocations";
+                }
+                std::cout << std::endl;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Decodes every image under resources/ and textures/ with each
+ * decoding backend that understands it, and reports throughput. Files are
+ * mapped and touched first so only decoding is timed
+ *
+ * @returns Exit code
+ */
+static int
+RunDecodeBenchmark() {
+    const char* const Directories[] = { "resources", "textures" };
+    const std::vector<std::string> Extensions = { ".jpg", ".jpeg", ".png" };
+    const int Repeats = 3;
+
+    std::vector<std::string> Paths;
+    for (const char* Directory : Directories) {
+        std::vector<std::string> Found = FindFilesWithExtensions(Directory, Extensions);
+        Paths.insert(Paths.end(), Found.begin(), Found.end());
+    }
+
+    std::cout << "Decode benchmark, " << Paths.size() << " files, best of " << Repeats << std::endl;
+    for (const ImageDecoder* Decoder : GetImageDecoders()) {
+        unsigned Files = 0;
+        size_t EncodedBytes = 0;
+        size_t DecodedBytes = 0;
+        double Seconds = 0.0;
+        for (const std::string& Path : Paths) {
+            MappedFile Encoded;
+            if (!Encoded.Open(Path) || !Decoder->CanDecode(Encoded.GetData(), Encoded.GetSize())) {
+                continue;
+            }
+            volatile unsigned char Touch = 0;
+            for (size_t ByteIdx = 0; ByteIdx < Encoded.GetSize(); ByteIdx += 4096) {
+                Touch += Encoded.GetData()[ByteIdx];
+            }
+
+            double Best = 1e9;
+            size_t Decoded = 0;
+            for (int RepeatIdx = 0; RepeatIdx < Repeats; ++RepeatIdx) {
+                int Width;
+                int Height;
+                int Channels;
+                auto Start = std::chrono::steady_clock::now();
+                unsigned char* Pixels = Decoder->Decode(Encoded.GetData(), Encoded.GetSize(), &Width, &Height, &Channels, TEXTURE_QUALITY_FULL);
+                Best = std::min(Best, std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count());
+                if (!Pixels) {
+                    break;
+                }
+                Decoded = (size_t)Width * Height * Channels;
+                Texture::FreeImage(Pixels);
+            }
+            if (!Decoded) {
+                std::cerr << "[Warn] " << Decoder->GetName() << " failed to decode " << Path << std::endl;
+                continue;
+            }
+
+            ++Files;
+            EncodedBytes += Encoded.GetSize();
+            DecodedBytes += Decoded;
+            Seconds += Best;
+        }
+
+        if (!Files) {
+            std::cout << "  " << Decoder->GetName() << ": no files it can decode" << std::endl;
+            continue;
+        }
+        const double MB = 1024.0 * 1024.0;
+        std::cout << "  " << Decoder->GetName() << ": " << Files << " files in " << Seconds * 1000.0 << " ms, "
+            << EncodedBytes / MB / Seconds << " MB/s encoded, " << DecodedBytes / MB / Seconds << " MB/s decoded" << std::endl;
+    }
+    return 0;
+}
+
+/**
+ * @brief Builds every program the scene starts with twice, first with
+ * program cache loads disabled and then from the entries the first pass
+ * stored, and reports both times. The driver may keep its own shader cache,
+ * so the cold time is a lower bound on a first run
+ */
+static void
+RunStartupBenchmark() {
+    std::cout << "Shader startup benchmark" << (Shader::InitParallelCompile() ? ", parallel compilation" : "") << std::endl;
+    for (int Warm = 0; Warm < 2; ++Warm) {
+        ProgramCache::SetLoadEnabled(Warm != 0);
+        double Start = glfwGetTime();
+        {
+            Shader ColorShader("shaders/color.vert", "shaders/color.frag", ShaderDefines(), SHADER_COMPILE_ASYNC);
+            ShaderVariants PhongVariants("shaders/basic.vert", "shaders/phong_material_texture.frag", InitPhongMaterial);
+            ShaderVariants GouraudVariants("shaders/gouraud.vert", "shaders/gouraud_texture.frag", InitPhongMaterial);
+            std::vector<ShaderDefines> Variants;
+            for (int TextureArray = 0; TextureArray < 2; ++TextureArray) {
+                for (int PointLightsLit = 0; PointLightsLit < 2; ++PointLightsLit) {
+                    for (int SpotlightLit = 0; SpotlightLit < 2; ++SpotlightLit) {
+                        ShaderDefines Defines;
+                        Defines
+                            .Set("NUM_POINT_LIGHTS", PointLightsLit ? MAX_POINT_LIGHTS : 0)
+                            .Set("HAS_SPOTLIGHT", SpotlightLit)
+                            .Set("HAS_SPECULAR_MAP", 0)
+                            .Set("TEXTURE_ARRAY", TextureArray);
+                        PhongVariants.Prepare(Defines);
+                        GouraudVariants.Prepare(Defines);
+                        Variants.push_back(Defines);
+                    }
+                }
+            }
+
+            ColorShader.Wait();
+            for (const ShaderDefines& Defines : Variants) {
+                PhongVariants.Get(Defines);
+                GouraudVariants.Get(Defines);
+            }
+        }
+        std::cout << "  " << (Warm ? "warm" : "cold") << ": " << (glfwGetTime() - Start) * 1000.0 << " ms" << std::endl;
+    }
+    ProgramCache::SetLoadEnabled(true);
+}
+
+int main(int argc, char** argv) {
+    bool VertexBenchmark = false;
+    bool LoadBenchmark = false;
+    bool GoldenComparison = false;
+    bool LodBenchmark = false;
+    bool StartupBenchmark = false;
+    size_t TextureBudgetBytes = TEXTURE_BUDGET_BYTES;
+    TextureQuality TextureTier = TEXTURE_QUALITY_FULL;
+    VertexPrecision MeshPrecision = VERTEX_PRECISION_FULL;
+    for (int ArgIdx = 1; ArgIdx < argc; ++ArgIdx) {
+        std::string Arg = argv[ArgIdx];
+        if (Arg == "--bench-vertex") {
+            VertexBenchmark = true;
+        }
+        else if (Arg == "--bench-load") {
+            LoadBenchmark = true;
+        }
+        else if (Arg == "--golden") {
+            GoldenComparison = true;
+        }
+        else if (Arg == "--bench-lod") {
+            LodBenchmark = true;
+        }
+        else if (Arg == "--bench-startup") {
+            StartupBenchmark = true;
+        }
+        else if (Arg == "--texture-budget-mb" && ArgIdx + 1 < argc) {
+            TextureBudgetBytes = std::stoull(argv[++ArgIdx]) * 1024 * 1024;
+        }
+        else if (Arg == "--texture-quality" && ArgIdx + 1 < argc) {
+            std::string Tier = argv[++ArgIdx];
+            if (Tier == "half") {
+                TextureTier = TEXTURE_QUALITY_HALF;
+            }
+            else if (Tier == "quarter") {
+                TextureTier = TEXTURE_QUALITY_QUARTER;
+            }
+            else if (Tier != "full") {
+                std::cerr << "[Warn] Unknown texture quality " << Tier << ", expected full, half or quarter" << std::endl;
+            }
+        }
+        else if (Arg == "--vertex-format" && ArgIdx + 1 < argc) {
+            std::string Format = argv[++ArgIdx];
+            if (Format == "compact") {
+                MeshPrecision = VERTEX_PRECISION_COMPACT;
+            }
+            else if (Format != "full") {
+                std::cerr << "[Warn] Unknown vertex format " << Format << ", expected full or compact" << std::endl;
+            }
+        }
+        else if (Arg == "--bench-decode") {
+            // NOTE: CPU only, like --cook
+            return RunDecodeBenchmark();
+        }
+        else if (Arg == "--cook") {
+            // NOTE: Offline step, needs no window or GL context
+            return RunCook();
+        }
+    }
+
     GLFWwindow* Window = 0;
     if (!glfwInit()) {
         std::cerr << "Failed to init glfw" << std::endl;
@@ -278,12 +984,112 @@ int main() {
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
 
-    unsigned FloorDiffuseTexture = Texture::LoadImageToTexture("resources/Sand_Diffuse.jpg");
-    unsigned MoonDiffuseTexture = Texture::LoadImageToTexture("resources/Moon_Diffuse.jpg");
-    unsigned PyramidDiffuseTexture = Texture::LoadImageToTexture("resources/Pyramid_Diffuse.jpg");
-    unsigned StoneSpecularTexture = Texture::LoadImageToTexture("resources/Stone_Specular2.jpg");
-    unsigned CarpetTexture = Texture::LoadImageToTexture("resources/rug/rug-Diff.png");
-    unsigned ChairTexture = Texture::LoadImageToTexture("resources/anubis/Diffuse.jpg");
+    ProgramCache::Prune();
+    if (StartupBenchmark) {
+        RunStartupBenchmark();
+        glfwTerminate();
+        return 0;
+    }
+
+    // NOTE: Submit every program before loading assets so the driver compiles
+    // them while textures and models load. Each is waited on at first use
+    double ShaderStartTime = glfwGetTime();
+    if (Shader::InitParallelCompile()) {
+        std::cout << "Using parallel shader compilation" << std::endl;
+    }
+    Shader ColorShader("shaders/color.vert", "shaders/color.frag", ShaderDefines(), SHADER_COMPILE_ASYNC);
+
+    SceneUniforms Scene;
+    LightData& DirLight = Scene.Lights.DirLight;
+    DirLight.Position = glm::vec3(-5.0, 30.5, -30.0);
+    DirLight.Direction = glm::vec3(1.0f, -150.0f, 1.0f);
+    DirLight.Ka = glm::vec3(0.55020, 0.55020, 0.55020);
+    DirLight.Kd = glm::vec3(0.55020, 0.55020, 0.55020);
+    DirLight.Ks = glm::vec3(1.0f);
+
+    const glm::vec3 PointLightPositions[MAX_POINT_LIGHTS] = {
+        glm::vec3(65.1f, 10.0f, 0.0f),
+        glm::vec3(5.0f, 10.0f, 30.0f),
+        glm::vec3(-35.0f, 10.0f, -50.1f),
+    };
+    const glm::vec3 PointLightColors[MAX_POINT_LIGHTS] = {
+        glm::vec3(1.00000f, 1.00000f, 1.00000f),
+        glm::vec3(1.00000f, 1.00000f, 0.90196f),
+        glm::vec3(1.00000f, 1.00000f, 0.90196f),
+    };
+    for (unsigned LightIdx = 0; LightIdx < MAX_POINT_LIGHTS; ++LightIdx) {
+        LightData& PointLight = Scene.Lights.PointLights[LightIdx];
+        PointLight.Position = PointLightPositions[LightIdx];
+        PointLight.Direction = glm::vec3(0.0f, -5.0f, 1.0f);
+        PointLight.Ka = PointLightColors[LightIdx];
+        PointLight.Kd = PointLightColors[LightIdx];
+        PointLight.Ks = glm::vec3(1.0f);
+        PointLight.Kc = 1.0f;
+        PointLight.Kl = 0.092f;
+        PointLight.Kq = 0.032f;
+    }
+
+    LightData& Spotlight = Scene.Lights.Spotlight;
+    Spotlight.Position = glm::vec3(0.0f, 3.5f, -20.0f);
+    Spotlight.Direction = glm::vec3(0.0f, -0.1f, 0.0f);
+    Spotlight.Ka = glm::vec3(1.00000f, 1.00000f, 0.80000f);
+    Spotlight.Kd = glm::vec3(1.00000f, 1.00000f, 0.80000f);
+    Spotlight.Ks = glm::vec3(1.0f);
+    Spotlight.Kc = 1.0f;
+    Spotlight.Kl = 0.092f;
+    Spotlight.Kq = 0.032f;
+    Spotlight.InnerCutOff = glm::cos(glm::radians(30.5f));
+    Spotlight.OuterCutOff = glm::cos(glm::radians(30.5f));
+
+    ShaderVariants PhongVariants("shaders/basic.vert", "shaders/phong_material_texture.frag", InitPhongMaterial);
+    ShaderVariants GouraudVariants("shaders/gouraud.vert", "shaders/gouraud_texture.frag", InitPhongMaterial);
+    ShadingSelector Shading;
+    Shading.mVariants = &PhongVariants;
+    Shading.mGouraudVariants = &GouraudVariants;
+    Shading.mLights = &Scene.Lights;
+    Shading.mPointLightsLit = true;
+    Shading.mShadingLod = true;
+    Shading.mTextureLoader = 0;
+    Shading.mBoundArray = 0;
+    BeginShadingFrame(&Shading, FPSCamera.GetPosition(), FieldOfViewY);
+    for (int TextureArray = 0; TextureArray < 2; ++TextureArray) {
+        for (int Compact = 0; Compact < 2; ++Compact) {
+            for (int PointLightsLit = 0; PointLightsLit < 2; ++PointLightsLit) {
+                for (int SpotlightLit = 0; SpotlightLit < 2; ++SpotlightLit) {
+                    // NOTE: Nothing binds a specular map to unit 1, so uMaterial.Ks samples
+                    // black and the specular term is always zero. Skip it entirely
+                    ShaderDefines& Defines = Shading.mDefines[TextureArray][Compact][PointLightsLit][SpotlightLit];
+                    Defines
+                        .Set("NUM_POINT_LIGHTS", PointLightsLit ? MAX_POINT_LIGHTS : 0)
+                        .Set("HAS_SPOTLIGHT", SpotlightLit)
+                        .Set("HAS_SPECULAR_MAP", 0)
+                        .Set("TEXTURE_ARRAY", TextureArray)
+                        .Set("COMPACT_VERTICES", Compact);
+                    // NOTE: Texture array draws are never compact, models are drawn from
+                    // 2D textures in the precision they were loaded with
+                    if (TextureArray ? !Compact : Compact == (MeshPrecision == VERTEX_PRECISION_COMPACT)) {
+                        PhongVariants.Prepare(Defines);
+                        GouraudVariants.Prepare(Defines);
+                    }
+                }
+            }
+        }
+    }
+
+    // NOTE: Decoded on the pool while models load, uploaded a few per frame in the render loop
+    ThreadPool Workers;
+    TextureLoader Loader(Workers, TextureTier);
+    Loader.GetResidency().SetBudget(TextureBudgetBytes);
+    Shading.mTextureLoader = &Loader;
+    TextureCache Textures(Loader);
+    // NOTE: Static scene materials share one array per format instead of a texture each
+    TextureArrayPacker Materials(TEXTURE_ARRAY_LAYER_SIZE, TextureTier);
+    unsigned FloorDiffuseLayer = Materials.Add("resources/Sand_Diffuse.jpg");
+    unsigned MoonDiffuseLayer = Materials.Add("resources/Moon_Diffuse.jpg");
+    unsigned PyramidDiffuseLayer = Materials.Add("resources/Pyramid_Diffuse.jpg");
+    unsigned StoneSpecularLayer = Materials.Add("resources/Stone_Specular2.jpg");
+    TextureHandle CarpetTexture = Textures.Load("resources/rug/rug-Diff.png");
+    TextureHandle ChairTexture = Textures.Load("resources/anubis/Diffuse.jpg");
 
     std::vector<float> CubeVertices = {
         -0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
@@ -335,12 +1141,7 @@ int main() {
     glGenBuffers(1, &CubeVBO);
     glBindBuffer(GL_ARRAY_BUFFER, CubeVBO);
     glBufferData(GL_ARRAY_BUFFER, CubeVertices.size() * sizeof(float), CubeVertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    MeshVertexFormat::Setup();
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
@@ -370,96 +1171,53 @@ int main() {
         -0.5f, 0.0f, 0.5f,      0.0f, 0.5f, 0.6f,       0.0f, 0.0f
     };
 
-    pyramidVerticesCount = CubeVertices.size();
-    unsigned PyramidVAO;     
-    glGenVertexArrays(1, &PyramidVAO); 
-    glBindVertexArray(PyramidVAO); 
-    unsigned PyramidVBO; 
-    glGenBuffers(1, &PyramidVBO); 
-    glBindBuffer(GL_ARRAY_BUFFER, PyramidVBO);   
-    glBufferData(GL_ARRAY_BUFFER, pyramidVertices.size() * sizeof(float), pyramidVertices.data(), GL_STATIC_DRAW); 
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0); 
-    glEnableVertexAttribArray(0);    
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
+    pyramidVerticesCount = pyramidVertices.size() / MESH_VERTEX_FLOATS;
+    unsigned PyramidVAO;
+    glGenVertexArrays(1, &PyramidVAO);
+    glBindVertexArray(PyramidVAO);
+    unsigned PyramidVBO;
+    glGenBuffers(1, &PyramidVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, PyramidVBO);
+    glBufferData(GL_ARRAY_BUFFER, pyramidVertices.size() * sizeof(float), pyramidVertices.data(), GL_STATIC_DRAW);
+    MeshVertexFormat::Setup();
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
-    Model Rug("resources/rug/rug.obj");
-    if (!Rug.Load())
+    Model Rug("resources/rug/rug.obj", MeshPrecision);
+    if (!Rug.Load(Workers))
     {
         std::cout << "Failed to load rug model!\n";
         glfwTerminate();
         return -1;
     }
 
-    Model Egy("resources/anubis/Egy1.obj");
-    if (!Egy.Load())
+    Model Egy("resources/anubis/Egy1.obj", MeshPrecision);
+    if (!Egy.Load(Workers))
     {
         std::cout << "Failed to load egy model!\n";
         glfwTerminate();
         return -1;
     }
 
-    Shader ColorShader("shaders/color.vert", "shaders/color.frag");
-
-    Shader PhongShaderMaterialTexture("shaders/basic.vert", "shaders/phong_material_texture.frag");
-    glUseProgram(PhongShaderMaterialTexture.GetId());
-    PhongShaderMaterialTexture.SetUniform3f("uDirLight.Position", glm::vec3(-5.0, 30.5, -30.0));
-    PhongShaderMaterialTexture.SetUniform3f("uDirLight.Direction", glm::vec3(1.0f, -150.0f, 1.0f));
-    PhongShaderMaterialTexture.SetUniform3f("uDirLight.Ka", glm::vec3(0.55020, 0.55020, 0.55020));
-    PhongShaderMaterialTexture.SetUniform3f("uDirLight.Kd", glm::vec3(0.55020, 0.55020, 0.55020));
-    PhongShaderMaterialTexture.SetUniform3f("uDirLight.Ks", glm::vec3(1.0f));
-
-    PhongShaderMaterialTexture.SetUniform3f("uPointLight.Position", glm::vec3(65.1f, 10.0f, 0.0f));
-    PhongShaderMaterialTexture.SetUniform3f("uPointLight.Direction", glm::vec3(0.0f, -5.0f, 1.0f));
-    PhongShaderMaterialTexture.SetUniform3f("uPointLight.Ka", glm::vec3(1.00000f, 1.00000f, 1.00000f));
-    PhongShaderMaterialTexture.SetUniform3f("uPointLight.Kd", glm::vec3(1.00000f, 1.00000f, 1.00000f));
-    PhongShaderMaterialTexture.SetUniform3f("uPointLight.Ks", glm::vec3(1.0f));
-    PhongShaderMaterialTexture.SetUniform1f("uPointLight.Kc", 1.0f);
-    PhongShaderMaterialTexture.SetUniform1f("uPointLight.Kl", 0.092f);
-    PhongShaderMaterialTexture.SetUniform1f("uPointLight.Kq", 0.032f);
-
-    PhongShaderMaterialTexture.SetUniform3f("uPointLightSecond.Position", glm::vec3(5.0f, 10.0f, 30.0f));
-    PhongShaderMaterialTexture.SetUniform3f("uPointLightSecond.Direction", glm::vec3(0.0f, -5.0f, 1.0f));
-    PhongShaderMaterialTexture.SetUniform3f("uPointLightSecond.Ka", glm::vec3(1.00000f, 1.00000f, 0.90196f));
-    PhongShaderMaterialTexture.SetUniform3f("uPointLightSecond.Kd", glm::vec3(1.00000f, 1.00000f, 0.90196f));
-    PhongShaderMaterialTexture.SetUniform3f("uPointLightSecond.Ks", glm::vec3(1.0f));
-    PhongShaderMaterialTexture.SetUniform1f("uPointLightSecond.Kc", 1.0f);
-    PhongShaderMaterialTexture.SetUniform1f("uPointLightSecond.Kl", 0.092f);
-    PhongShaderMaterialTexture.SetUniform1f("uPointLightSecond.Kq", 0.032f);
-
-    PhongShaderMaterialTexture.SetUniform3f("uPointLightThird.Position", glm::vec3(-35.0f, 10.0f, -50.1f));
-    PhongShaderMaterialTexture.SetUniform3f("uPointLightThird.Direction", glm::vec3(0.0f, -5.0f, 1.0f));
-    PhongShaderMaterialTexture.SetUniform3f("uPointLightThird.Ka", glm::vec3(1.00000f, 1.00000f, 0.90196f));
-    PhongShaderMaterialTexture.SetUniform3f("uPointLightThird.Kd", glm::vec3(1.00000f, 1.00000f, 0.90196f));
-    PhongShaderMaterialTexture.SetUniform3f("uPointLightThird.Ks", glm::vec3(1.0f));
-    PhongShaderMaterialTexture.SetUniform1f("uPointLightThird.Kc", 1.0f);
-    PhongShaderMaterialTexture.SetUniform1f("uPointLightThird.Kl", 0.092f);
-    PhongShaderMaterialTexture.SetUniform1f("uPointLightThird.Kq", 0.032f);
-
-    PhongShaderMaterialTexture.SetUniform3f("uSpotlight.Position", glm::vec3(0.0f, 3.5f, -20.0f));
-    PhongShaderMaterialTexture.SetUniform3f("uSpotlight.Direction", glm::vec3(0.0f, -0.1f, 0.0f));
-    PhongShaderMaterialTexture.SetUniform3f("uSpotlight.Ka", glm::vec3(1.00000f, 1.00000f, 0.80000f));
-    PhongShaderMaterialTexture.SetUniform3f("uSpotlight.Kd", glm::vec3(1.00000f, 1.00000f, 0.80000f));
-    PhongShaderMaterialTexture.SetUniform3f("uSpotlight.Ks", glm::vec3(1.0f));
-    PhongShaderMaterialTexture.SetUniform1f("uSpotlight.Kc", 1.0f);
-    PhongShaderMaterialTexture.SetUniform1f("uSpotlight.Kl", 0.092f);
-    PhongShaderMaterialTexture.SetUniform1f("uSpotlight.Kq", 0.032f);
-    PhongShaderMaterialTexture.SetUniform1f("uSpotlight.InnerCutOff", glm::cos(glm::radians(30.5f)));
-    PhongShaderMaterialTexture.SetUniform1f("uSpotlight.OuterCutOff", glm::cos(glm::radians(30.5f)));
-    PhongShaderMaterialTexture.SetUniform1i("uMaterial.Kd", 0);
-    PhongShaderMaterialTexture.SetUniform1i("uMaterial.Ks", 1);
-    PhongShaderMaterialTexture.SetUniform1f("uMaterial.Shininess", 128.0f);
-    glUseProgram(0);
+    if (LoadBenchmark) {
+        RunLoadBenchmark(MeshPrecision);
+        glfwTerminate();
+        return 0;
+    }
 
-    glm::mat4 Projection = glm::perspective(45.0f, WindowWidth / (float)WindowHeight, 0.1f, 100.0f);
+    if (VertexBenchmark) {
+        RunVertexBenchmark(Egy);
+        glfwTerminate();
+        return 0;
+    }
+
+    double ShaderWaitTime = glfwGetTime();
+    ColorShader.Wait();
+    PhongVariants.Get(Shading.mDefines[0][MeshPrecision == VERTEX_PRECISION_COMPACT][1][0]);
+    std::cout << "Shader startup took " << (glfwGetTime() - ShaderStartTime) * 1000.0 << " ms, blocked for "
+        << (glfwGetTime() - ShaderWaitTime) * 1000.0 << " ms" << std::endl;
+
+    glm::mat4 Projection = glm::perspective(FieldOfViewY, WindowWidth / (float)WindowHeight, 0.1f, 100.0f);
     glm::mat4 View = glm::lookAt(FPSCamera.GetPosition(), FPSCamera.GetTarget(), FPSCamera.GetUp());
     glm::mat4 ModelMatrix(1.0f);
 
@@ -468,85 +1226,77 @@ int main() {
     float EndTime = glfwGetTime();
     glClearColor(0.1f, 0.1f, 0.2f, 0.0f);
 
-    Shader* CurrentShader = &PhongShaderMaterialTexture;
+    // NOTE: Decoded on the pool alongside the loader's textures, waits for its own only
+    Materials.Pack(Workers);
+    SceneObjects Objects = { CubeVAO, PyramidVAO, &Rug, &Egy, Materials.Get(FloorDiffuseLayer), Materials.Get(MoonDiffuseLayer),
+        Materials.Get(PyramidDiffuseLayer), Materials.Get(StoneSpecularLayer), CarpetTexture, ChairTexture };
+
+    if (GoldenComparison || LodBenchmark) {
+        Loader.Finish();
+        Scene.Frame.Projection = Projection;
+        Scene.Frame.View = View;
+        Scene.Frame.ViewPos = FPSCamera.GetPosition();
+        Scene.Upload();
+        int Result = 0;
+        if (GoldenComparison) {
+            Result = RunGoldenComparison(&Shading, Objects);
+        }
+        if (LodBenchmark) {
+            RunShadingLodBenchmark(&Shading, Objects);
+        }
+        glfwTerminate();
+        return Result;
+    }
+
+    // NOTE: Resolve per-frame uniforms once, the render loop only uses handles
+    Uniform<glm::vec3> ColorUniform = ColorShader.GetUniform<glm::vec3>("uColor");
+    ShaderWatcher Watcher("shaders");
     int pulsCount = 0;
     double r = 0.0;
     while (!glfwWindowShouldClose(Window)) {
         glfwPollEvents();
-        HandleInput(&State, *CurrentShader);
-
-        CurrentShader = &PhongShaderMaterialTexture;
+        // NOTE: Reloads compile in the background, programs are only swapped here between frames
+        for (const std::string& ChangedFile : Watcher.TakeChangedFiles()) {
+            if (ColorShader.UsesSource(ChangedFile)) {
+                ColorShader.Reload();
+            }
+            PhongVariants.ReloadIfUses(ChangedFile);
+            GouraudVariants.ReloadIfUses(ChangedFile);
+        }
+        if (ColorShader.PollReload()) {
+            ColorUniform = ColorShader.GetUniform<glm::vec3>("uColor");
+        }
+        PhongVariants.PollReload();
+        if (Loader.Update() && !Loader.GetPendingCount()) {
+            Textures.PrintStats();
+            Loader.GetResidency().PrintStats();
+        }
+        GouraudVariants.PollReload();
+        HandleInput(&State, Scene.Lights.Spotlight);
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        Projection = glm::perspective(45.0f, WindowWidth / (float)WindowHeight, 0.1f, 100.0f);
+        Projection = glm::perspective(FieldOfViewY, WindowWidth / (float)WindowHeight, 0.1f, 100.0f);
         View = glm::lookAt(FPSCamera.GetPosition(), FPSCamera.GetTarget(), FPSCamera.GetUp());
         StartTime = glfwGetTime();
-        glUseProgram(CurrentShader->GetId());
-        CurrentShader->SetProjection(Projection);
-        CurrentShader->SetView(View);
-        CurrentShader->SetUniform3f("uViewPos", FPSCamera.GetPosition());
         r = ((double)rand() / (RAND_MAX)) * 100;
-        if (r >= 97.90) {
-            CurrentShader->SetUniform3f("uPointLight.Ka", glm::vec3(0.0, 0.0, 0.0));
-            CurrentShader->SetUniform3f("uPointLight.Kd", glm::vec3(0.0, 0.0, 0.0));
-            CurrentShader->SetUniform3f("uPointLightSecond.Ka", glm::vec3(0.0, 0.0, 0.0));
-            CurrentShader->SetUniform3f("uPointLightSecond.Kd", glm::vec3(0.0, 0.0, 0.0));
-            CurrentShader->SetUniform3f("uPointLightThird.Ka", glm::vec3(0.0, 0.0, 0.0));
-            CurrentShader->SetUniform3f("uPointLightThird.Kd", glm::vec3(0.0, 0.0, 0.0));
-        }
-        else
-        {
-            CurrentShader->SetUniform3f("uPointLight.Ka", glm::vec3(0.347059, 0.347059, 0.347059));
-            CurrentShader->SetUniform3f("uPointLight.Kd", glm::vec3(0.347059, 0.347059, 0.347059));
-            CurrentShader->SetUniform3f("uPointLightSecond.Ka", glm::vec3(0.347059, 0.347059, 0.347059));
-            CurrentShader->SetUniform3f("uPointLightSecond.Kd", glm::vec3(0.347059, 0.347059, 0.347059));
-            CurrentShader->SetUniform3f("uPointLightThird.Ka", glm::vec3(0.347059, 0.347059, 0.347059));
-            CurrentShader->SetUniform3f("uPointLightThird.Kd", glm::vec3(0.347059, 0.347059, 0.347059));
+        glm::vec3 PointLightColor = r >= 97.90 ? glm::vec3(0.0, 0.0, 0.0) : glm::vec3(0.347059, 0.347059, 0.347059);
+        for (unsigned LightIdx = 0; LightIdx < MAX_POINT_LIGHTS; ++LightIdx) {
+            Scene.Lights.PointLights[LightIdx].Ka = PointLightColor;
+            Scene.Lights.PointLights[LightIdx].Kd = PointLightColor;
         }
+        Scene.Frame.Projection = Projection;
+        Scene.Frame.View = View;
+        Scene.Frame.ViewPos = FPSCamera.GetPosition();
+        Scene.Upload();
+        Shading.mPointLightsLit = PointLightColor != glm::vec3(0.0f);
 
         glClearColor(0.1f, 0.1f, 0.2f, 0.0f);
 
-        ModelMatrix = glm::mat4(1.0f);
-        ModelMatrix = glm::translate(ModelMatrix, glm::vec3(0.5, 2.7 + ((double)rand() / (RAND_MAX)) / 8, +0.5));
-        ModelMatrix = glm::translate(ModelMatrix, glm::vec3(x, y, z));
-        ModelMatrix = glm::scale(ModelMatrix, glm::vec3(7.0f, 7.0f, 7.0f));
-        CurrentShader->SetModel(ModelMatrix);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, CarpetTexture);
-        Rug.Render();
-     
-        ModelMatrix = glm::mat4(1.0f);
-        ModelMatrix = glm::translate(ModelMatrix, glm::vec3(-38.0f, -1.0f, -38.0f));
-        CurrentShader->SetModel(ModelMatrix);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, ChairTexture);
-        Egy.Render();
-
-        ModelMatrix = glm::mat4(1.0f);
-        ModelMatrix = glm::translate(ModelMatrix, glm::vec3(13.0f, -1.0f, 42.0f));
-        CurrentShader->SetModel(ModelMatrix);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, ChairTexture);
-        Egy.Render();
-
-        ModelMatrix = glm::mat4(1.0f);
-        ModelMatrix = glm::translate(ModelMatrix, glm::vec3(53.0f, -1.0f, 10.0f));
-        CurrentShader->SetModel(ModelMatrix);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, ChairTexture);
-        Egy.Render();
-
-        DrawFloor(CubeVAO, *CurrentShader, FloorDiffuseTexture);
-        DrawMoon(CubeVAO, *CurrentShader, MoonDiffuseTexture);
-        DrawPyramid(PyramidVAO, *CurrentShader, glm::vec3(65.0, -5.0, 0.0), glm::vec3(25.0, 25.0, 25.0), PyramidDiffuseTexture);
-        DrawPyramid(PyramidVAO, *CurrentShader, glm::vec3(-35.0, -5.0, -50.0), glm::vec3(25.0, 25.0, 25.0), PyramidDiffuseTexture);
-        DrawPyramid(PyramidVAO, *CurrentShader, glm::vec3(5.0, -5.0, 30.0), glm::vec3(25.0, 25.0, 25.0), PyramidDiffuseTexture);
-        DrawStones(CubeVAO, *CurrentShader, StoneSpecularTexture);
+        BeginShadingFrame(&Shading, FPSCamera.GetPosition(), FieldOfViewY);
+        DrawLitObjects(&Shading, Objects, ((double)rand() / (RAND_MAX)) / 8);
 
         glUseProgram(ColorShader.GetId());
 
-        ColorShader.SetProjection(Projection);
-        ColorShader.SetView(View);
         ModelMatrix = glm::mat4(1.0f);
         ModelMatrix = glm::translate(ModelMatrix, glm::vec3(0.0f, 1.0f, -2.0f));
         ColorShader.SetModel(ModelMatrix);
@@ -558,10 +1308,10 @@ int main() {
         ColorShader.SetModel(ModelMatrix);
         glBindVertexArray(PyramidVAO);
         if (r >= 97.90) {
-            ColorShader.SetUniform3f("uColor", glm::vec3(0.00000, 0.00000, 0.00000));
+            ColorShader.Set(ColorUniform, glm::vec3(0.00000, 0.00000, 0.00000));
         }
         else
-            ColorShader.SetUniform3f("uColor", glm::vec3(1.00000, 1.00000, 0.80000));
+            ColorShader.Set(ColorUniform, glm::vec3(1.00000, 1.00000, 0.80000));
         glDrawArrays(GL_TRIANGLES, 0, 36);
 
         //Draw point light for second pyramid
@@ -571,10 +1321,10 @@ int main() {
         ColorShader.SetModel(ModelMatrix);
         glBindVertexArray(PyramidVAO);
         if (r >= 97.90) {
-            ColorShader.SetUniform3f("uColor", glm::vec3(0.00000, 0.00000, 0.00000));
+            ColorShader.Set(ColorUniform, glm::vec3(0.00000, 0.00000, 0.00000));
         }
         else
-            ColorShader.SetUniform3f("uColor", glm::vec3(1.00000, 1.00000, 0.80000));
+            ColorShader.Set(ColorUniform, glm::vec3(1.00000, 1.00000, 0.80000));
         glDrawArrays(GL_TRIANGLES, 0, 36);
 
         //Draw point light for third pyramid
@@ -584,10 +1334,10 @@ int main() {
         ColorShader.SetModel(ModelMatrix);
         glBindVertexArray(PyramidVAO);
         if (r >= 97.90) {
-            ColorShader.SetUniform3f("uColor", glm::vec3(0.00000, 0.00000, 0.00000));
+            ColorShader.Set(ColorUniform, glm::vec3(0.00000, 0.00000, 0.00000));
         }
         else
-            ColorShader.SetUniform3f("uColor", glm::vec3(1.00000, 1.00000, 0.80000));
+            ColorShader.Set(ColorUniform, glm::vec3(1.00000, 1.00000, 0.80000));
         glDrawArrays(GL_TRIANGLES, 0, 36);
 
         // Draw spotlight
@@ -595,7 +1345,7 @@ int main() {
         ModelMatrix = glm::translate(ModelMatrix, glm::vec3(-5.0f, 25.5f, -30.0f));
         ModelMatrix = glm::scale(ModelMatrix, glm::vec3(1.0f));
         ColorShader.SetModel(ModelMatrix);
-        ColorShader.SetUniform3f("uColor", glm::vec3(1.00000, 1.00000, 0.80000));
+        ColorShader.Set(ColorUniform, glm::vec3(1.00000, 1.00000, 0.80000));
 
         glBindVertexArray(CubeVAO);
         glDrawArrays(GL_TRIANGLES, 0, 36);
@@ -605,13 +1355,16 @@ int main() {
         ModelMatrix = glm::translate(ModelMatrix, glm::vec3(-5.0, 27.0f, -30.0));
         ModelMatrix = glm::scale(ModelMatrix, glm::vec3(0.5f));
         ColorShader.SetModel(ModelMatrix);
-        ColorShader.SetUniform3f("uColor", glm::vec3(1.0f, 1.0f, 0.8f));
+        ColorShader.Set(ColorUniform, glm::vec3(1.0f, 1.0f, 0.8f));
         glBindVertexArray(CubeVAO);
         glDrawArrays(GL_TRIANGLES, 0, 36);
 
         glBindVertexArray(0);
         glUseProgram(0);
         glfwSwapBuffers(Window);
+        if (!pulsCount) {
+            std::cout << "First frame after " << glfwGetTime() * 1000.0 << " ms" << std::endl;
+        }
 
         pulsCount++;
         EndTime = glfwGetTime();
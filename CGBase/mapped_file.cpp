@@ -0,0 +1,112 @@
+#include "mapped_file.hpp"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile()
+    : mData(0), mSize(0), mFile(INVALID_HANDLE_VALUE), mMapping(0) {}
+#else
+MappedFile::MappedFile()
+    : mData(0), mSize(0), mFile(-1) {}
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool
+MappedFile::Open(const std::string& filePath) {
+    Close();
+#ifdef _WIN32
+    mFile = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    if (mFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER Size;
+    if (!GetFileSizeEx(mFile, &Size) || !Size.QuadPart) {
+        Close();
+        return false;
+    }
+
+    mMapping = CreateFileMappingA(mFile, 0, PAGE_READONLY, 0, 0, 0);
+    if (!mMapping) {
+        Close();
+        return false;
+    }
+
+    mData = (const unsigned char*)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+    if (!mData) {
+        Close();
+        return false;
+    }
+    mSize = (size_t)Size.QuadPart;
+#else
+    mFile = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (mFile < 0) {
+        return false;
+    }
+
+    struct stat Stat;
+    if (fstat(mFile, &Stat) || !Stat.st_size) {
+        Close();
+        return false;
+    }
+
+    void* Data = mmap(0, (size_t)Stat.st_size, PROT_READ, MAP_PRIVATE, mFile, 0);
+    if (Data == MAP_FAILED) {
+        Close();
+        return false;
+    }
+    // NOTE: Everything gets read right after mapping, start paging it in now
+    madvise(Data, (size_t)Stat.st_size, MADV_WILLNEED);
+    mData = (const unsigned char*)Data;
+    mSize = (size_t)Stat.st_size;
+#endif
+    return true;
+}
+
+void
+MappedFile::Close() {
+#ifdef _WIN32
+    if (mData) {
+        UnmapViewOfFile(mData);
+    }
+    if (mMapping) {
+        CloseHandle(mMapping);
+    }
+    if (mFile != INVALID_HANDLE_VALUE) {
+        CloseHandle(mFile);
+    }
+    mMapping = 0;
+    mFile = INVALID_HANDLE_VALUE;
+#else
+    if (mData) {
+        munmap((void*)mData, mSize);
+    }
+    if (mFile >= 0) {
+        close(mFile);
+    }
+    mFile = -1;
+#endif
+    mData = 0;
+    mSize = 0;
+}
+
+const unsigned char*
+MappedFile::GetData() const {
+    return mData;
+}
+
+size_t
+MappedFile::GetSize() const {
+    return mSize;
+}
@@ -0,0 +1,45 @@
+/**
+ * @file mapped_file.hpp
+ * @brief Read-only memory mapped file. Contents come straight from the OS
+ * page cache, nothing is copied into the process
+ *
+ */
+
+#pragma once
+#include <string>
+#include <cstddef>
+
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Maps the whole file, unmapping whatever was mapped before
+     *
+     * @param filePath File path
+     *
+     * @returns true - Success, false - Missing, empty or unmappable file
+     */
+    bool Open(const std::string& filePath);
+
+    /**
+     * @brief Unmaps the file, no-op if nothing is mapped
+     *
+     */
+    void Close();
+
+    const unsigned char* GetData() const;
+    size_t GetSize() const;
+private:
+    const unsigned char* mData;
+    size_t mSize;
+#ifdef _WIN32
+    void* mFile;
+    void* mMapping;
+#else
+    int mFile;
+#endif
+};
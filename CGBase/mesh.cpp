@@ -1,71 +1,127 @@
 #include "mesh.hpp"
+#include <cstring>
 
-Mesh::Mesh(const aiMesh* mesh, aiMaterial* MeshMaterial, const std::string& resPath)
-    : mVerticesCount(0), mIndicesCount(0) {
-    processMesh(mesh, MeshMaterial, resPath);
-}
+Mesh::Mesh(unsigned vao, unsigned ebo, const CookedModelMesh& mesh, const MeshEncoding& encoding)
+    : mVAO(vao), mEBO(ebo), mIndicesCount(mesh.IndexCount), mVerticesCount(mesh.VertexCount),
+    mBaseVertex(mesh.FirstVertex), mEncoding(encoding),
+    mBoundsMin(mesh.BoundsMin[0], mesh.BoundsMin[1], mesh.BoundsMin[2]),
+    mBoundsMax(mesh.BoundsMax[0], mesh.BoundsMax[1], mesh.BoundsMax[2]) {}
 
 void
-Mesh::Render() const {
+Mesh::Render(const Shader& shader) const {
     glBindVertexArray(mVAO);
+    if (mEncoding.Precision == VERTEX_PRECISION_COMPACT) {
+        shader.SetUniform3f(Shader::POSITION_ORIGIN, mEncoding.PositionOrigin);
+        shader.SetUniform3f(Shader::POSITION_EXTENT, mEncoding.PositionExtent);
+    }
     if (mIndicesCount) {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
-        glDrawElements(GL_TRIANGLES, mIndicesCount, GL_UNSIGNED_INT, (void*)0);
-        glBindVertexArray(mVAO);
-        return;
+        glDrawElementsBaseVertex(GL_TRIANGLES, mIndicesCount, mEncoding.IndexType, (void*)mEncoding.IndexOffset, mBaseVertex);
+    }
+    else {
+        glDrawArrays(GL_TRIANGLES, mBaseVertex, mVerticesCount);
     }
-    glDrawArrays(GL_TRIANGLES, 0, mVerticesCount);
     glBindVertexArray(0);
 }
 
+glm::vec3
+Mesh::GetBoundsMin() const {
+    return mBoundsMin;
+}
+
+glm::vec3
+Mesh::GetBoundsMax() const {
+    return mBoundsMax;
+}
+
+unsigned
+Mesh::GetVertexCount() const {
+    return mVerticesCount;
+}
+
 void
-Mesh::processMesh(const aiMesh* mesh, aiMaterial* MeshMaterial, const std::string& resPath) {
-    const aiVector3D Zero3D(0.0f, 0.0f, 0.0f);
-    std::vector<float> Vertices;
+Mesh::WriteVertices(const aiMesh* mesh, MeshVertex* out) {
+    const aiVector3D* UVs = mesh->mTextureCoords[0];
     for (unsigned VertexIndex = 0; VertexIndex < mesh->mNumVertices; ++VertexIndex) {
-        std::vector<float> Position = { mesh->mVertices[VertexIndex].x, mesh->mVertices[VertexIndex].y, mesh->mVertices[VertexIndex].z };
-        Vertices.insert(Vertices.end(), Position.begin(), Position.end());
-        //Upotreba normala za boje
-        std::vector<float> Normals = { mesh->mNormals[VertexIndex].x, mesh->mNormals[VertexIndex].y, mesh->mNormals[VertexIndex].z };
-        Vertices.insert(Vertices.end(), Normals.begin(), Normals.end());
-        //aiColor4D Color = { 1.0f, 1.0f, 1.0f, 1.0f };
-        // NOTE(Jovan): If material isn't being rendered properly
-        // comment out the line below
-        //aiGetMaterialColor(MeshMaterial, AI_MATKEY_COLOR_DIFFUSE, &Color); // <-- This one
-        //std::vector<float> VertexColor = { Color.r, Color.g, Color.b };
-        //Vertices.insert(Vertices.end(), VertexColor.begin(), VertexColor.end());
-
+        MeshVertex& Vertex = out[VertexIndex];
+        Vertex.Position = glm::vec3(mesh->mVertices[VertexIndex].x, mesh->mVertices[VertexIndex].y, mesh->mVertices[VertexIndex].z);
+        Vertex.Normal = glm::vec3(mesh->mNormals[VertexIndex].x, mesh->mNormals[VertexIndex].y, mesh->mNormals[VertexIndex].z);
+        Vertex.UV = UVs ? glm::vec2(UVs[VertexIndex].x, UVs[VertexIndex].y) : glm::vec2(0.0f);
+    }
+}
 
+unsigned
+Mesh::WriteIndices(const aiMesh* mesh, unsigned* out) {
+    unsigned* Start = out;
+    for (unsigned FaceIndex = 0; FaceIndex < mesh->mNumFaces; ++FaceIndex) {
+        const aiFace& Face = mesh->mFaces[FaceIndex];
+        if (Face.mNumIndices != 3) {
+            continue;
+        }
+        *out++ = Face.mIndices[0];
+        *out++ = Face.mIndices[1];
+        *out++ = Face.mIndices[2];
     }
+    return (unsigned)(out - Start);
+}
 
-    mVerticesCount = Vertices.size();
+MeshOptimizerStats
+Mesh::Process(const aiMesh* mesh, std::vector<MeshVertex>& vertices, std::vector<unsigned>& indices, CookedModelMesh& entry) {
+    // NOTE: The optimizer reads back what it reorders, so it works here
+    // rather than in mapped memory, which may be uncached
+    vertices.resize(mesh->mNumVertices);
+    indices.resize((size_t)mesh->mNumFaces * 3);
+    WriteVertices(mesh, vertices.data());
+    entry.VertexCount = mesh->mNumVertices;
+    entry.IndexCount = WriteIndices(mesh, indices.data());
+    entry.Material = mesh->mMaterialIndex;
+    indices.resize(entry.IndexCount);
+    MeshOptimizerStats Stats = OptimizeMesh(vertices.data(), entry.VertexCount, indices.data(), entry.IndexCount);
 
-    glGenVertexArrays(1, &mVAO);
-    glGenBuffers(1, &mVBO);
-    glBindVertexArray(mVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, mVBO);
-    glBufferData(GL_ARRAY_BUFFER, mVerticesCount * sizeof(float), Vertices.data(), GL_STATIC_DRAW);
-    float Stride = 6 * sizeof(float);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, Stride, (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, Stride, (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glm::vec3 Min(0.0f);
+    glm::vec3 Max(0.0f);
+    for (unsigned VertexIndex = 0; VertexIndex < mesh->mNumVertices; ++VertexIndex) {
+        glm::vec3 Position(mesh->mVertices[VertexIndex].x, mesh->mVertices[VertexIndex].y, mesh->mVertices[VertexIndex].z);
+        Min = VertexIndex ? glm::min(Min, Position) : Position;
+        Max = VertexIndex ? glm::max(Max, Position) : Position;
+    }
+    memcpy(entry.BoundsMin, &Min[0], sizeof(entry.BoundsMin));
+    memcpy(entry.BoundsMax, &Max[0], sizeof(entry.BoundsMax));
+    return Stats;
+}
 
-    std::vector<unsigned> Indices;
-    for (unsigned FaceIndex = 0; FaceIndex < mesh->mNumFaces; ++FaceIndex) {
-        const aiFace& Face = mesh->mFaces[FaceIndex];
-        Indices.push_back(Face.mIndices[0]);
-        Indices.push_back(Face.mIndices[1]);
-        Indices.push_back(Face.mIndices[2]);
+QuantizationError
+Mesh::Encode(const MeshVertex* vertices, const unsigned* indices, const CookedModelMesh& entry,
+    VertexPrecision precision, MeshEncoding& encoding, void* vertexOut, void* indexOut) {
+    QuantizationError Error = { 0.0f, 0.0f, 0.0f, 0.0f };
+    if (precision == VERTEX_PRECISION_COMPACT) {
+        glm::vec3 Origin(entry.BoundsMin[0], entry.BoundsMin[1], entry.BoundsMin[2]);
+        glm::vec3 Extent = glm::vec3(entry.BoundsMax[0], entry.BoundsMax[1], entry.BoundsMax[2]) - Origin;
+        encoding.Precision = VERTEX_PRECISION_COMPACT;
+        encoding.PositionOrigin = Origin;
+        encoding.PositionExtent = Extent;
+        Error = QuantizeVertices(vertices, entry.VertexCount, Origin, Extent, (CompactMeshVertex*)vertexOut);
+    }
+    else {
+        encoding.Precision = VERTEX_PRECISION_FULL;
+        encoding.PositionOrigin = glm::vec3(0.0f);
+        encoding.PositionExtent = glm::vec3(1.0f);
+        memcpy(vertexOut, vertices, entry.VertexCount * sizeof(MeshVertex));
     }
-    mIndicesCount = Indices.size();
 
-    if (mIndicesCount) {
-        glGenBuffers(1, &mEBO);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, Indices.size() * sizeof(float), Indices.data(), GL_STATIC_DRAW);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    if (encoding.IndexType == GL_UNSIGNED_SHORT) {
+        uint16_t* Out = (uint16_t*)indexOut;
+        for (unsigned IndexIdx = 0; IndexIdx < entry.IndexCount; ++IndexIdx) {
+            Out[IndexIdx] = (uint16_t)indices[IndexIdx];
+        }
     }
-    glBindVertexArray(0);
-}
\ No newline at end of file
+    else {
+        memcpy(indexOut, indices, entry.IndexCount * sizeof(unsigned));
+    }
+    return Error;
+}
+
+unsigned
+Mesh::GetDrawnVertexCount() const {
+    return mIndicesCount ? mIndicesCount : mVerticesCount;
+}
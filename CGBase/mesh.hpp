@@ -13,39 +13,125 @@
 
 #include <GL/glew.h>
 #include <assimp/scene.h>
+#include <glm/glm.hpp>
 #include<vector>
+#include "vertex_format.hpp"
+#include "cooked_model.hpp"
+#include "mesh_optimizer.hpp"
+#include "vertex_quantization.hpp"
+#include "shader.hpp"
+
+/**
+ * @brief How a mesh is stored in its model's shared buffers
+ */
+struct MeshEncoding {
+    // NOTE: GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, indices start IndexOffset bytes into the buffer
+    GLenum IndexType;
+    size_t IndexOffset;
+    // NOTE: Compact vertices are drawn with COMPACT_VERTICES shaders, fed
+    // PositionOrigin and PositionExtent as uniforms. Unused for full precision
+    VertexPrecision Precision;
+    glm::vec3 PositionOrigin;
+    glm::vec3 PositionExtent;
+};
 
 class Mesh {
 public:
     /**
-     * @brief Ctor - buffers mesh data
+     * @brief Ctor - draws a range of buffers shared by every mesh of a model
      *
-     * @param mesh - Assimp mesh
-     * @param MeshMaterial - Assimp material
-     * @param resPath - Resource relative path. For loading textures, etc...
+     * @param vao VAO with the model's vertex and index buffers set up
+     * @param ebo Index buffer
+     * @param mesh Where the mesh lies in the buffers, cooked or filled by Process
+     * @param encoding Index width and offset, and how positions decode
      *
      */
-    Mesh(const aiMesh* mesh, aiMaterial* MeshMaterial, const std::string& resPath);
+    Mesh(unsigned vao, unsigned ebo, const CookedModelMesh& mesh, const MeshEncoding& encoding);
 
     /**
      * @brief Renders the mesh
      *
+     * @param shader Bound shader, built with COMPACT_VERTICES if the mesh is compact
+     *
      */
-    void Render() const;
-private:
-    unsigned mVAO;
-    unsigned mVBO;
-    unsigned mEBO;
-    unsigned mIndicesCount;
-    unsigned mVerticesCount;
+    void Render(const Shader& shader) const;
+
+    /**
+     * @brief Axis aligned bounds of mesh vertices, in model space
+     *
+     */
+    glm::vec3 GetBoundsMin() const;
+    glm::vec3 GetBoundsMax() const;
+
+    /**
+     * @brief Number of vertices a Render() call submits
+     *
+     */
+    unsigned GetDrawnVertexCount() const;
+
+    /**
+     * @brief Number of vertices stored in the vertex buffer
+     *
+     */
+    unsigned GetVertexCount() const;
+
+    /**
+     * @brief Interleaves vertices of an aiMesh. Writes sequentially and
+     * never reads out, so it can target mapped GL memory
+     *
+     * @param mesh Assimp mesh
+     * @param out mesh->mNumVertices vertices
+     */
+    static void WriteVertices(const aiMesh* mesh, MeshVertex* out);
+
+    /**
+     * @brief Writes the triangle indices of an aiMesh, same rules as WriteVertices
+     *
+     * @param mesh Assimp mesh
+     * @param out mesh->mNumFaces * 3 indices, points and lines are dropped so fewer may be written
+     *
+     * @returns Number of indices written
+     */
+    static unsigned WriteIndices(const aiMesh* mesh, unsigned* out);
 
     /**
-     * @brief Buffers mesh data into GL
+     * @brief CPU side of loading a mesh: interleaves vertices, flattens
+     * indices, runs OptimizeMesh and computes bounds. Touches no GL state
+     * and nothing shared, meshes of a model can be processed in parallel
      *
-     * @param mesh Assimp mesh struct
-     * @param MeshMaterial Assimp material struct
-     * @param resPath Resource path, used for loading textures
+     * @param mesh Assimp mesh
+     * @param vertices Filled with the optimized vertices
+     * @param indices Filled with the optimized indices
+     * @param entry Its FirstVertex and FirstIndex are kept, the rest is filled in
      *
+     * @returns Optimizer measurements
      */
-    void processMesh(const aiMesh* mesh, aiMaterial* MeshMaterial, const std::string& resPath);
+    static MeshOptimizerStats Process(const aiMesh* mesh, std::vector<MeshVertex>& vertices, std::vector<unsigned>& indices, CookedModelMesh& entry);
+
+    /**
+     * @brief Writes a mesh in the model's vertex format, into its range of
+     * the shared buffers. Writes sequentially and never reads out
+     *
+     * @param vertices entry.VertexCount vertices
+     * @param indices entry.IndexCount indices
+     * @param entry Mesh counts and bounds
+     * @param precision Vertex format of the model
+     * @param encoding Index type and offset set by the caller, position decoding is filled in
+     * @param vertexOut Where the mesh's vertices go
+     * @param indexOut Where the mesh's indices go, encoding.IndexType wide
+     *
+     * @returns Quantization error, all zero for full precision
+     */
+    static QuantizationError Encode(const MeshVertex* vertices, const unsigned* indices, const CookedModelMesh& entry,
+        VertexPrecision precision, MeshEncoding& encoding, void* vertexOut, void* indexOut);
+private:
+    unsigned mVAO;
+    unsigned mEBO;
+    unsigned mIndicesCount;
+    unsigned mVerticesCount;
+    // NOTE: Where the mesh starts in the model's buffers
+    unsigned mBaseVertex;
+    MeshEncoding mEncoding;
+    glm::vec3 mBoundsMin;
+    glm::vec3 mBoundsMax;
 };
\ No newline at end of file
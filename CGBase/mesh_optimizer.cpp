@@ -0,0 +1,272 @@
+#include "mesh_optimizer.hpp"
+#include <vector>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+// NOTE: FIFO caches are simulated with timestamps: an entry is cached while
+// at most cacheSize entries, itself included, were inserted since it was.
+// Times start at cacheSize + 1 so zeroed stamps are misses
+static bool
+touchFifo(std::vector<unsigned>& stamps, unsigned& time, size_t entry, unsigned cacheSize) {
+    if (time - stamps[entry] <= cacheSize) {
+        return false;
+    }
+    stamps[entry] = time++;
+    return true;
+}
+
+static void
+simulate(const unsigned* indices, size_t indexCount, unsigned vertexCount, size_t vertexStride, size_t* misses, size_t* fetched) {
+    unsigned VertexTime = MESH_OPTIMIZER_CACHE_SIZE + 1;
+    unsigned LineTime = MESH_OPTIMIZER_FETCH_LINES + 1;
+    std::vector<unsigned> VertexStamps(vertexCount, 0);
+    std::vector<unsigned> LineStamps(((size_t)vertexCount * vertexStride + MESH_OPTIMIZER_FETCH_LINE - 1) / MESH_OPTIMIZER_FETCH_LINE + 1, 0);
+    *misses = 0;
+    *fetched = 0;
+    for (size_t IndexIdx = 0; IndexIdx < indexCount; ++IndexIdx) {
+        unsigned Vertex = indices[IndexIdx];
+        if (!touchFifo(VertexStamps, VertexTime, Vertex, MESH_OPTIMIZER_CACHE_SIZE)) {
+            continue;
+        }
+
+        ++*misses;
+        size_t Start = Vertex * vertexStride;
+        for (size_t Line = Start / MESH_OPTIMIZER_FETCH_LINE; Line <= (Start + vertexStride - 1) / MESH_OPTIMIZER_FETCH_LINE; ++Line) {
+            *fetched += touchFifo(LineStamps, LineTime, Line, MESH_OPTIMIZER_FETCH_LINES) ? MESH_OPTIMIZER_FETCH_LINE : 0;
+        }
+    }
+}
+
+float
+ComputeAcmr(const unsigned* indices, size_t indexCount, unsigned vertexCount) {
+    if (indexCount < 3) {
+        return 0.0f;
+    }
+
+    size_t Misses;
+    size_t Fetched;
+    simulate(indices, indexCount, vertexCount, sizeof(MeshVertex), &Misses, &Fetched);
+    return (float)Misses / (indexCount / 3);
+}
+
+float
+ComputeOverfetch(const unsigned* indices, size_t indexCount, unsigned vertexCount, size_t vertexStride) {
+    if (!vertexCount) {
+        return 0.0f;
+    }
+
+    size_t Misses;
+    size_t Fetched;
+    simulate(indices, indexCount, vertexCount, vertexStride, &Misses, &Fetched);
+    return (float)Fetched / ((size_t)vertexCount * vertexStride);
+}
+
+void
+OptimizeVertexCache(unsigned* indices, size_t indexCount, unsigned vertexCount) {
+    size_t TriangleCount = indexCount / 3;
+    if (!TriangleCount || !vertexCount) {
+        return;
+    }
+
+    // NOTE: Triangles around each vertex, packed. Live counts how many of them aren't emitted yet
+    std::vector<unsigned> Live(vertexCount, 0);
+    for (size_t IndexIdx = 0; IndexIdx < TriangleCount * 3; ++IndexIdx) {
+        ++Live[indices[IndexIdx]];
+    }
+    std::vector<size_t> AdjacencyStart(vertexCount + 1, 0);
+    for (unsigned Vertex = 0; Vertex < vertexCount; ++Vertex) {
+        AdjacencyStart[Vertex + 1] = AdjacencyStart[Vertex] + Live[Vertex];
+    }
+    std::vector<unsigned> Adjacency(TriangleCount * 3);
+    std::vector<size_t> Fill(AdjacencyStart.begin(), AdjacencyStart.end() - 1);
+    for (size_t IndexIdx = 0; IndexIdx < TriangleCount * 3; ++IndexIdx) {
+        Adjacency[Fill[indices[IndexIdx]]++] = (unsigned)(IndexIdx / 3);
+    }
+
+    std::vector<unsigned> Result;
+    Result.reserve(TriangleCount * 3);
+    std::vector<bool> Emitted(TriangleCount, false);
+    std::vector<unsigned> Stamps(vertexCount, 0);
+    std::vector<unsigned> DeadEnds;
+    std::vector<unsigned> Candidates;
+    unsigned Time = MESH_OPTIMIZER_CACHE_SIZE + 1;
+    unsigned Cursor = 0;
+    int Fanning = 0;
+    while (Fanning >= 0) {
+        Candidates.clear();
+        for (size_t AdjIdx = AdjacencyStart[Fanning]; AdjIdx < AdjacencyStart[Fanning + 1]; ++AdjIdx) {
+            unsigned Triangle = Adjacency[AdjIdx];
+            if (Emitted[Triangle]) {
+                continue;
+            }
+
+            for (unsigned Corner = 0; Corner < 3; ++Corner) {
+                unsigned Vertex = indices[Triangle * 3 + Corner];
+                Result.push_back(Vertex);
+                DeadEnds.push_back(Vertex);
+                Candidates.push_back(Vertex);
+                --Live[Vertex];
+                touchFifo(Stamps, Time, Vertex, MESH_OPTIMIZER_CACHE_SIZE);
+            }
+            Emitted[Triangle] = true;
+        }
+
+        // NOTE: Next fan is around the candidate that stays cached the
+        // longest while its remaining triangles are emitted
+        Fanning = -1;
+        int BestPriority = -1;
+        for (unsigned Vertex : Candidates) {
+            if (!Live[Vertex]) {
+                continue;
+            }
+
+            int Priority = 0;
+            if (Time - Stamps[Vertex] + 2 * Live[Vertex] <= MESH_OPTIMIZER_CACHE_SIZE) {
+                Priority = (int)(Time - Stamps[Vertex]);
+            }
+            if (Priority > BestPriority) {
+                BestPriority = Priority;
+                Fanning = (int)Vertex;
+            }
+        }
+        if (Fanning >= 0) {
+            continue;
+        }
+
+        // NOTE: Dead end, try recently used vertices first, then the next unfinished one in order
+        while (!DeadEnds.empty() && Fanning < 0) {
+            unsigned Vertex = DeadEnds.back();
+            DeadEnds.pop_back();
+            Fanning = Live[Vertex] ? (int)Vertex : -1;
+        }
+        while (Fanning < 0 && Cursor < vertexCount) {
+            Fanning = Live[Cursor] ? (int)Cursor : -1;
+            ++Cursor;
+        }
+    }
+
+    std::copy(Result.begin(), Result.end(), indices);
+}
+
+void
+OptimizeOverdraw(unsigned* indices, size_t indexCount, const MeshVertex* vertices, unsigned vertexCount) {
+    size_t TriangleCount = indexCount / 3;
+    if (TriangleCount < 2 || !vertexCount) {
+        return;
+    }
+
+    // NOTE: A triangle missing the cache on all three vertices starts a
+    // cluster. The cache isn't empty there, so moving clusters around can
+    // still cost misses where a cluster used to reuse its predecessor's vertices
+    std::vector<size_t> ClusterStarts;
+    std::vector<unsigned> Stamps(vertexCount, 0);
+    unsigned Time = MESH_OPTIMIZER_CACHE_SIZE + 1;
+    for (size_t Triangle = 0; Triangle < TriangleCount; ++Triangle) {
+        unsigned Misses = 0;
+        for (unsigned Corner = 0; Corner < 3; ++Corner) {
+            Misses += touchFifo(Stamps, Time, indices[Triangle * 3 + Corner], MESH_OPTIMIZER_CACHE_SIZE);
+        }
+        if (Misses == 3 || !Triangle) {
+            ClusterStarts.push_back(Triangle);
+        }
+    }
+    ClusterStarts.push_back(TriangleCount);
+    size_t ClusterCount = ClusterStarts.size() - 1;
+    if (ClusterCount < 2) {
+        return;
+    }
+
+    // NOTE: Area weighted centroid and normal per cluster
+    std::vector<glm::vec3> Centroids(ClusterCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> Normals(ClusterCount, glm::vec3(0.0f));
+    glm::vec3 MeshCentroid(0.0f);
+    float MeshArea = 0.0f;
+    for (size_t Cluster = 0; Cluster < ClusterCount; ++Cluster) {
+        float ClusterArea = 0.0f;
+        for (size_t Triangle = ClusterStarts[Cluster]; Triangle < ClusterStarts[Cluster + 1]; ++Triangle) {
+            const glm::vec3& A = vertices[indices[Triangle * 3 + 0]].Position;
+            const glm::vec3& B = vertices[indices[Triangle * 3 + 1]].Position;
+            const glm::vec3& C = vertices[indices[Triangle * 3 + 2]].Position;
+            glm::vec3 Normal = glm::cross(B - A, C - A);
+            float Area = glm::length(Normal);
+            Centroids[Cluster] += (A + B + C) * (Area / 3.0f);
+            Normals[Cluster] += Normal;
+            ClusterArea += Area;
+        }
+        MeshCentroid += Centroids[Cluster];
+        MeshArea += ClusterArea;
+        Centroids[Cluster] = ClusterArea > 0.0f ? Centroids[Cluster] / ClusterArea : vertices[indices[ClusterStarts[Cluster] * 3]].Position;
+    }
+    if (MeshArea > 0.0f) {
+        MeshCentroid = MeshCentroid / MeshArea;
+    }
+
+    std::vector<float> Facing(ClusterCount);
+    std::vector<unsigned> Order(ClusterCount);
+    for (size_t Cluster = 0; Cluster < ClusterCount; ++Cluster) {
+        float NormalLength = glm::length(Normals[Cluster]);
+        Facing[Cluster] = NormalLength > 0.0f ? glm::dot(Centroids[Cluster] - MeshCentroid, Normals[Cluster] / NormalLength) : 0.0f;
+        Order[Cluster] = (unsigned)Cluster;
+    }
+    std::stable_sort(Order.begin(), Order.end(), [&Facing](unsigned a, unsigned b) { return Facing[a] > Facing[b]; });
+
+    std::vector<unsigned> Result;
+    Result.reserve(TriangleCount * 3);
+    for (unsigned Cluster : Order) {
+        Result.insert(Result.end(), indices + ClusterStarts[Cluster] * 3, indices + ClusterStarts[Cluster + 1] * 3);
+    }
+
+    // NOTE: Keeps the cache order when the cluster order costs too many misses
+    float CacheAcmr = ComputeAcmr(indices, TriangleCount * 3, vertexCount);
+    float SortedAcmr = ComputeAcmr(Result.data(), Result.size(), vertexCount);
+    if (SortedAcmr > CacheAcmr * (1.0f + MESH_OPTIMIZER_OVERDRAW_ACMR_SLACK)) {
+        return;
+    }
+    std::copy(Result.begin(), Result.end(), indices);
+}
+
+void
+OptimizeVertexFetch(MeshVertex* vertices, unsigned vertexCount, unsigned* indices, size_t indexCount) {
+    const unsigned UNASSIGNED = ~0u;
+    std::vector<unsigned> Remap(vertexCount, UNASSIGNED);
+    unsigned Next = 0;
+    for (size_t IndexIdx = 0; IndexIdx < indexCount; ++IndexIdx) {
+        unsigned& Target = Remap[indices[IndexIdx]];
+        if (Target == UNASSIGNED) {
+            Target = Next++;
+        }
+        indices[IndexIdx] = Target;
+    }
+    for (unsigned Vertex = 0; Vertex < vertexCount; ++Vertex) {
+        if (Remap[Vertex] == UNASSIGNED) {
+            Remap[Vertex] = Next++;
+        }
+    }
+
+    std::vector<MeshVertex> Source(vertices, vertices + vertexCount);
+    for (unsigned Vertex = 0; Vertex < vertexCount; ++Vertex) {
+        vertices[Remap[Vertex]] = Source[Vertex];
+    }
+}
+
+MeshOptimizerStats
+OptimizeMesh(MeshVertex* vertices, unsigned vertexCount, unsigned* indices, size_t indexCount) {
+    MeshOptimizerStats Stats;
+    Stats.AcmrBefore = ComputeAcmr(indices, indexCount, vertexCount);
+    Stats.OverfetchBefore = ComputeOverfetch(indices, indexCount, vertexCount, sizeof(MeshVertex));
+    OptimizeVertexCache(indices, indexCount, vertexCount);
+    OptimizeOverdraw(indices, indexCount, vertices, vertexCount);
+    OptimizeVertexFetch(vertices, vertexCount, indices, indexCount);
+    Stats.AcmrAfter = ComputeAcmr(indices, indexCount, vertexCount);
+    Stats.OverfetchAfter = ComputeOverfetch(indices, indexCount, vertexCount, sizeof(MeshVertex));
+    return Stats;
+}
+
+std::string
+FormatMeshOptimizerStats(const MeshOptimizerStats& stats) {
+    std::ostringstream Out;
+    Out << std::fixed << std::setprecision(2) << "ACMR " << stats.AcmrBefore << " -> " << stats.AcmrAfter
+        << ", vertex fetch " << stats.OverfetchBefore << "x -> " << stats.OverfetchAfter << "x";
+    return Out.str();
+}
@@ -0,0 +1,108 @@
+/**
+ * @file mesh_optimizer.hpp
+ * @brief Reorders triangle lists for the post-transform vertex cache
+ * (Tipsify), for less overdraw (outward facing clusters first) and for
+ * vertex fetch locality, and measures how well a triangle list does
+ *
+ */
+
+#pragma once
+#include <cstddef>
+#include <string>
+#include "vertex_format.hpp"
+
+// NOTE: FIFO size both the optimizer targets and the analysis simulates,
+// conservative for current hardware
+static const unsigned MESH_OPTIMIZER_CACHE_SIZE = 16;
+// NOTE: Vertex fetch is simulated as a FIFO of cache lines, 4 KB in total
+static const unsigned MESH_OPTIMIZER_FETCH_LINE = 64;
+static const unsigned MESH_OPTIMIZER_FETCH_LINES = 64;
+// NOTE: Relative ACMR increase OptimizeOverdraw accepts for its cluster order
+static const float MESH_OPTIMIZER_OVERDRAW_ACMR_SLACK = 0.05f;
+
+struct MeshOptimizerStats {
+    // NOTE: Average cache miss ratio, vertex shader invocations per triangle. 0.5 is the ideal for large meshes, 3 the worst
+    float AcmrBefore;
+    float AcmrAfter;
+    // NOTE: Bytes fetched from vertex memory over the size of the vertex buffer, 1 is ideal
+    float OverfetchBefore;
+    float OverfetchAfter;
+};
+
+/**
+ * @brief Simulates the post-transform cache over a triangle list
+ *
+ * @param indices Triangle list
+ * @param indexCount Number of indices, a multiple of 3
+ * @param vertexCount Number of vertices indices refer to
+ *
+ * @returns Vertex shader invocations per triangle
+ */
+float ComputeAcmr(const unsigned* indices, size_t indexCount, unsigned vertexCount);
+
+/**
+ * @brief Simulates vertex memory reads made by post-transform cache misses
+ *
+ * @param indices Triangle list
+ * @param indexCount Number of indices, a multiple of 3
+ * @param vertexCount Number of vertices indices refer to
+ * @param vertexStride Size of a vertex in bytes
+ *
+ * @returns Bytes fetched over vertexCount * vertexStride
+ */
+float ComputeOverfetch(const unsigned* indices, size_t indexCount, unsigned vertexCount, size_t vertexStride);
+
+/**
+ * @brief Reorders triangles so consecutive ones share vertices while they're
+ * still cached. Tipsify, Sander et al. 2007: fans around the vertex
+ * that stays cached longest, jumps to recently used vertices at dead ends
+ *
+ * @param indices Triangle list, reordered in place
+ * @param indexCount Number of indices, a multiple of 3
+ * @param vertexCount Number of vertices indices refer to
+ */
+void OptimizeVertexCache(unsigned* indices, size_t indexCount, unsigned vertexCount);
+
+/**
+ * @brief Splits a cache optimized triangle list at triangles that miss
+ * the cache on all three vertices, and sorts the clusters so ones facing
+ * out from the mesh center come first. Those occlude the rest from most
+ * directions. The cache order within a cluster is kept, but vertices
+ * shared across cluster boundaries can miss again, so the sorted order
+ * is only used when ACMR grows by at most MESH_OPTIMIZER_OVERDRAW_ACMR_SLACK
+ *
+ * @param indices Triangle list, reordered in place
+ * @param indexCount Number of indices, a multiple of 3
+ * @param vertices Vertices indices refer to
+ * @param vertexCount Number of vertices
+ */
+void OptimizeOverdraw(unsigned* indices, size_t indexCount, const MeshVertex* vertices, unsigned vertexCount);
+
+/**
+ * @brief Renumbers vertices in order of first use so fetches walk the
+ * vertex buffer forwards. Unused vertices are moved to the end
+ *
+ * @param vertices Vertices, permuted in place
+ * @param vertexCount Number of vertices
+ * @param indices Triangle list, remapped in place
+ * @param indexCount Number of indices
+ */
+void OptimizeVertexFetch(MeshVertex* vertices, unsigned vertexCount, unsigned* indices, size_t indexCount);
+
+/**
+ * @brief Runs every pass above in order. Vertices are expected to be
+ * welded already, see POSTPROCESS_FLAGS
+ *
+ * @param vertices Vertices, permuted in place
+ * @param vertexCount Number of vertices
+ * @param indices Triangle list, reordered in place
+ * @param indexCount Number of indices, a multiple of 3
+ *
+ * @returns Measurements before and after
+ */
+MeshOptimizerStats OptimizeMesh(MeshVertex* vertices, unsigned vertexCount, unsigned* indices, size_t indexCount);
+
+/**
+ * @brief One line summary for load and cook logs
+ */
+std::string FormatMeshOptimizerStats(const MeshOptimizerStats& stats);
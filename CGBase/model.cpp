@@ -1,12 +1,40 @@
 #include "model.hpp"
+#include "mapped_file.hpp"
+#include <filesystem>
+#include <algorithm>
 
-Model::Model(std::string filename) {
+Model::Model(std::string filename, VertexPrecision precision)
+    : mPrecision(precision), mVAO(0), mVBO(0), mEBO(0), mCooked(false), mVertexBytes(0), mIndexBytes(0),
+    mBoundsMin(0.0f), mBoundsMax(0.0f) {
     mFilename = filename;
     mDirectory = filename.substr(0, filename.find_last_of('/'));
 }
 
+Model::~Model() {
+    if (mVAO) {
+        glDeleteVertexArrays(1, &mVAO);
+        glDeleteBuffers(1, &mVBO);
+        glDeleteBuffers(1, &mEBO);
+    }
+}
+
+// NOTE: Maps a freshly sized buffer for writing, 0 when empty or mapping fails
+static void*
+mapBuffer(GLenum target, size_t size) {
+    glBufferData(target, size, 0, GL_STATIC_DRAW);
+    if (!size) {
+        return 0;
+    }
+    return glMapBufferRange(target, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+}
+
 bool
-Model::Load() {
+Model::Load(ThreadPool& pool, bool allowCooked) {
+    if (allowCooked && loadCooked(pool)) {
+        mCooked = true;
+        return true;
+    }
+
     Assimp::Importer Importer;
     const aiScene* Scene = Importer.ReadFile(mFilename, POSTPROCESS_FLAGS);
 
@@ -14,20 +42,237 @@ Model::Load() {
         std::cerr << "[Err] Failed to load model:" << std::endl << Importer.GetErrorString() << std::endl;
         return false;
     }
-    mMeshes.reserve(Scene->mNumMeshes);
+
+    // NOTE: Triangulated faces have at most 3 indices, index space is
+    // reserved for that so ranges are known before any mesh is processed.
+    // Dropped points and lines leave a gap at the end of a range
+    std::vector<CookedModelMesh> Entries(Scene->mNumMeshes);
+    std::vector<size_t> IndexCapacities(Scene->mNumMeshes);
+    uint32_t VertexCount = 0;
     for (unsigned MeshIdx = 0; MeshIdx < Scene->mNumMeshes; ++MeshIdx) {
-        aiMaterial* MeshMaterial = Scene->mMaterials[Scene->mMeshes[MeshIdx]->mMaterialIndex];
-        Mesh CurrMesh(Scene->mMeshes[MeshIdx], MeshMaterial, mDirectory);
-        mMeshes.push_back(CurrMesh);
+        Entries[MeshIdx].FirstVertex = VertexCount;
+        Entries[MeshIdx].VertexCount = Scene->mMeshes[MeshIdx]->mNumVertices;
+        IndexCapacities[MeshIdx] = (size_t)Scene->mMeshes[MeshIdx]->mNumFaces * 3;
+        VertexCount += Entries[MeshIdx].VertexCount;
+    }
 
+    std::vector<MeshOptimizerStats> Stats(Scene->mNumMeshes);
+    upload(pool, Entries, IndexCapacities, [&](unsigned meshIdx, MeshEncoding& encoding, void* vertexOut, void* indexOut) {
+        std::vector<MeshVertex> Vertices;
+        std::vector<unsigned> Indices;
+        Stats[meshIdx] = Mesh::Process(Scene->mMeshes[meshIdx], Vertices, Indices, Entries[meshIdx]);
+        return Mesh::Encode(Vertices.data(), Indices.data(), Entries[meshIdx], mPrecision, encoding, vertexOut, indexOut);
+    });
+    for (unsigned MeshIdx = 0; MeshIdx < Stats.size(); ++MeshIdx) {
+        std::cout << "  mesh " << MeshIdx << ": " << FormatMeshOptimizerStats(Stats[MeshIdx]) << std::endl;
     }
-    std::cout << mFilename << " Loaded " << mMeshes.size() << " meshes" << std::endl;
     return true;
 }
 
 void
-Model::Render() {
+Model::Render(const Shader& shader) {
+    for (const Mesh& mesh : mMeshes) {
+        mesh.Render(shader);
+    }
+}
+
+VertexPrecision
+Model::GetPrecision() const {
+    return mPrecision;
+}
+
+glm::vec3
+Model::GetBoundsCenter() const {
+    return (mBoundsMin + mBoundsMax) * 0.5f;
+}
+
+float
+Model::GetBoundsRadius() const {
+    return glm::length(mBoundsMax - mBoundsMin) * 0.5f;
+}
+
+unsigned
+Model::GetDrawnVertexCount() const {
+    unsigned Count = 0;
+    for (const Mesh& mesh : mMeshes) {
+        Count += mesh.GetDrawnVertexCount();
+    }
+    return Count;
+}
+
+unsigned
+Model::GetVertexCount() const {
+    unsigned Count = 0;
     for (const Mesh& mesh : mMeshes) {
-        mesh.Render();
+        Count += mesh.GetVertexCount();
+    }
+    return Count;
+}
+
+bool
+Model::IsCooked() const {
+    return mCooked;
+}
+
+size_t
+Model::GetVertexBytes() const {
+    return mVertexBytes;
+}
+
+size_t
+Model::GetIndexBytes() const {
+    return mIndexBytes;
+}
+
+bool
+Model::loadCooked(ThreadPool& pool) {
+    std::string CookedPath = GetCookedModelPath(mFilename);
+    std::error_code Error;
+    auto CookedTime = std::filesystem::last_write_time(CookedPath, Error);
+    if (Error) {
+        return false;
+    }
+    auto SourceTime = std::filesystem::last_write_time(mFilename, Error);
+    if (!Error && SourceTime > CookedTime) {
+        std::cerr << "[Warn] " << CookedPath << " is older than its source, rerun --cook" << std::endl;
+        return false;
+    }
+
+    MappedFile File;
+    CookedModel Cooked;
+    if (!File.Open(CookedPath) || !ParseCookedModel(File.GetData(), File.GetSize(), &Cooked)) {
+        std::cerr << "[Warn] Ignoring unreadable " << CookedPath << std::endl;
+        return false;
+    }
+
+    std::vector<CookedModelMesh> Entries(Cooked.Meshes, Cooked.Meshes + Cooked.Header->MeshCount);
+    if (mPrecision == VERTEX_PRECISION_COMPACT) {
+        std::vector<size_t> IndexCapacities(Entries.size());
+        for (unsigned MeshIdx = 0; MeshIdx < Entries.size(); ++MeshIdx) {
+            IndexCapacities[MeshIdx] = Entries[MeshIdx].IndexCount;
+        }
+        const MeshVertex* Vertices = (const MeshVertex*)Cooked.Vertices;
+        const unsigned* Indices = (const unsigned*)Cooked.Indices;
+        upload(pool, Entries, IndexCapacities, [&](unsigned meshIdx, MeshEncoding& encoding, void* vertexOut, void* indexOut) {
+            const CookedModelMesh& Entry = Entries[meshIdx];
+            return Mesh::Encode(Vertices + Entry.FirstVertex, Indices + Entry.FirstIndex, Entry, mPrecision, encoding, vertexOut, indexOut);
+        });
+        return true;
+    }
+
+    // NOTE: Full precision is the cooked layout, the blobs are uploaded as they are
+    glGenVertexArrays(1, &mVAO);
+    glGenBuffers(1, &mVBO);
+    glGenBuffers(1, &mEBO);
+    glBindVertexArray(mVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+    glBufferData(GL_ARRAY_BUFFER, Cooked.Header->VertexSize, Cooked.Vertices, GL_STATIC_DRAW);
+    MeshVertexFormat::Setup();
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, Cooked.Header->IndexSize, Cooked.Indices, GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    mVertexBytes = Cooked.Header->VertexSize;
+    mIndexBytes = Cooked.Header->IndexSize;
+
+    mMeshes.reserve(Entries.size());
+    for (unsigned MeshIdx = 0; MeshIdx < Entries.size(); ++MeshIdx) {
+        MeshEncoding Encoding = { GL_UNSIGNED_INT, (size_t)Entries[MeshIdx].FirstIndex * sizeof(unsigned), VERTEX_PRECISION_FULL, glm::vec3(0.0f), glm::vec3(1.0f) };
+        mMeshes.emplace_back(mVAO, mEBO, Entries[MeshIdx], Encoding);
+        mBoundsMin = MeshIdx ? glm::min(mBoundsMin, mMeshes.back().GetBoundsMin()) : mMeshes.back().GetBoundsMin();
+        mBoundsMax = MeshIdx ? glm::max(mBoundsMax, mMeshes.back().GetBoundsMax()) : mMeshes.back().GetBoundsMax();
+    }
+    std::cout << mFilename << " Loaded " << mMeshes.size() << " meshes from " << CookedPath << ", "
+        << mVertexBytes / 1024 << " KB vertices, " << mIndexBytes / 1024 << " KB indices" << std::endl;
+    return true;
+}
+
+void
+Model::upload(ThreadPool& pool, std::vector<CookedModelMesh>& entries, const std::vector<size_t>& indexCapacities, const MeshWriter& write) {
+    // NOTE: Meshes go back to back into one pair of buffers. Index width is
+    // picked per mesh, indices are local to their mesh so its vertex count
+    // decides. 32 bit ranges are kept 4 byte aligned
+    size_t VertexStride = mPrecision == VERTEX_PRECISION_COMPACT ? sizeof(CompactMeshVertex) : sizeof(MeshVertex);
+    std::vector<MeshEncoding> Encodings(entries.size());
+    size_t VertexCount = 0;
+    size_t IndexBytes = 0;
+    for (unsigned MeshIdx = 0; MeshIdx < entries.size(); ++MeshIdx) {
+        bool Narrow = mPrecision == VERTEX_PRECISION_COMPACT && entries[MeshIdx].VertexCount <= 65536;
+        size_t IndexSize = Narrow ? sizeof(uint16_t) : sizeof(uint32_t);
+        IndexBytes = (IndexBytes + IndexSize - 1) / IndexSize * IndexSize;
+        Encodings[MeshIdx].IndexType = Narrow ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        Encodings[MeshIdx].IndexOffset = IndexBytes;
+        IndexBytes += indexCapacities[MeshIdx] * IndexSize;
+        VertexCount = std::max(VertexCount, (size_t)entries[MeshIdx].FirstVertex + entries[MeshIdx].VertexCount);
+    }
+    size_t VertexBytes = VertexCount * VertexStride;
+
+    glGenVertexArrays(1, &mVAO);
+    glGenBuffers(1, &mVBO);
+    glGenBuffers(1, &mEBO);
+    glBindVertexArray(mVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+    unsigned char* Vertices = (unsigned char*)mapBuffer(GL_ARRAY_BUFFER, VertexBytes);
+    if (mPrecision == VERTEX_PRECISION_COMPACT) {
+        CompactMeshVertexFormat::Setup();
+    }
+    else {
+        MeshVertexFormat::Setup();
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
+    unsigned char* Indices = (unsigned char*)mapBuffer(GL_ELEMENT_ARRAY_BUFFER, IndexBytes);
+
+    // NOTE: Jobs write straight into the mapped buffers, GL calls stay on
+    // this thread. The pool may be busy decoding textures, only this
+    // model's jobs are waited for
+    std::vector<QuantizationError> Errors(entries.size());
+    auto WriteMeshes = [&](unsigned char* vertices, unsigned char* indices) {
+        JobGroup Jobs(pool);
+        for (unsigned MeshIdx = 0; MeshIdx < entries.size(); ++MeshIdx) {
+            Jobs.Submit([&, vertices, indices, MeshIdx] {
+                Errors[MeshIdx] = write(MeshIdx, Encodings[MeshIdx], vertices + entries[MeshIdx].FirstVertex * VertexStride,
+                    indices + Encodings[MeshIdx].IndexOffset);
+            });
+        }
+        Jobs.Wait();
+    };
+
+    bool Mapped = (Vertices || !VertexBytes) && (Indices || !IndexBytes);
+    if (Mapped) {
+        WriteMeshes(Vertices, Indices);
+    }
+    // NOTE: Contents are undefined if unmapping fails, both are written again below
+    bool Unmapped = true;
+    if (Vertices) {
+        Unmapped = glUnmapBuffer(GL_ARRAY_BUFFER) && Unmapped;
+    }
+    if (Indices) {
+        Unmapped = glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER) && Unmapped;
+    }
+    if (!Mapped || !Unmapped) {
+        std::vector<unsigned char> StagedVertices(VertexBytes);
+        std::vector<unsigned char> StagedIndices(IndexBytes);
+        WriteMeshes(StagedVertices.data(), StagedIndices.data());
+        glBufferSubData(GL_ARRAY_BUFFER, 0, VertexBytes, StagedVertices.data());
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, IndexBytes, StagedIndices.data());
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    mVertexBytes = VertexBytes;
+    mIndexBytes = IndexBytes;
+
+    mMeshes.reserve(entries.size());
+    for (unsigned MeshIdx = 0; MeshIdx < entries.size(); ++MeshIdx) {
+        mMeshes.emplace_back(mVAO, mEBO, entries[MeshIdx], Encodings[MeshIdx]);
+        mBoundsMin = MeshIdx ? glm::min(mBoundsMin, mMeshes.back().GetBoundsMin()) : mMeshes.back().GetBoundsMin();
+        mBoundsMax = MeshIdx ? glm::max(mBoundsMax, mMeshes.back().GetBoundsMax()) : mMeshes.back().GetBoundsMax();
+    }
+    std::cout << mFilename << " Loaded " << mMeshes.size() << " meshes, " << mVertexBytes / 1024 << " KB vertices, "
+        << mIndexBytes / 1024 << " KB indices" << std::endl;
+    if (mPrecision == VERTEX_PRECISION_COMPACT) {
+        for (unsigned MeshIdx = 0; MeshIdx < Errors.size(); ++MeshIdx) {
+            std::cout << "  mesh " << MeshIdx << ": " << (Encodings[MeshIdx].IndexType == GL_UNSIGNED_SHORT ? "16" : "32")
+                << " bit indices, " << FormatQuantizationError(Errors[MeshIdx]) << std::endl;
+        }
     }
 }
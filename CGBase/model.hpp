@@ -21,11 +21,15 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include "shader.hpp"
 #include "mesh.hpp"
+#include "thread_pool.hpp"
+#include <functional>
 
 
 #define POSITION_LOCATION 0
 
-#define POSTPROCESS_FLAGS (aiProcess_Triangulate | aiProcess_FlipUVs)
+// NOTE: Welding identical vertices is what gives the post-transform cache
+// anything to reuse, see OptimizeMesh
+#define POSTPROCESS_FLAGS (aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices)
 #define INVALID_MATERIAL 0xFFFFFFFF
 
 enum EBufferType {
@@ -48,23 +52,109 @@ public:
      * @brief Ctor - sets up data for model loading in Assimp
      *
      * @param filename - Model path
+     * @param precision - Vertex format meshes are stored in
      *
      */
-    Model(std::string filename);
+    Model(std::string filename, VertexPrecision precision = VERTEX_PRECISION_FULL);
+    ~Model();
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
 
     /**
-     * @brief Loads all the meshes and model data
+     * @brief Loads all the meshes and model data. Uses the cooked version
+     * (see GetCookedModelPath) when it exists and isn't older than the
+     * source, Assimp otherwise. Meshes imported with Assimp are processed
+     * on the pool, one job each, then uploaded together. Call once
+     *
+     * @param pool Workers for mesh processing, only the jobs Load submits are waited for
+     * @param allowCooked false - Always import with Assimp
      *
      * @returns true - Success, false - Failure
      */
-    bool Load();
+    bool Load(ThreadPool& pool, bool allowCooked = true);
+
+    /**
+     * @brief Whether Load read the cooked version
+     *
+     */
+    bool IsCooked() const;
 
     /**
      * @brief Renderable Render implementation
      *
+     * @param shader Bound shader, built with COMPACT_VERTICES when GetPrecision is VERTEX_PRECISION_COMPACT
+     *
+     */
+    void Render(const Shader& shader);
+
+    /**
+     * @brief Vertex format meshes are stored in, picks the shader permutation
+     *
      */
-    void Render();
+    VertexPrecision GetPrecision() const;
 
+    /**
+     * @brief Center and radius of a sphere enclosing all meshes, in model space
+     *
+     */
+    glm::vec3 GetBoundsCenter() const;
+    float GetBoundsRadius() const;
+
+    /**
+     * @brief Number of vertices a Render() call submits, summed over all meshes
+     *
+     */
+    unsigned GetDrawnVertexCount() const;
+
+    /**
+     * @brief Number of vertices stored, summed over all meshes
+     *
+     */
+    unsigned GetVertexCount() const;
+
+    /**
+     * @brief GPU memory taken by the model's vertex and index buffers
+     *
+     */
+    size_t GetVertexBytes() const;
+    size_t GetIndexBytes() const;
+
+private:
+    // NOTE: Fills one mesh's ranges of the mapped buffers, runs on a worker
+    using MeshWriter = std::function<QuantizationError(unsigned meshIdx, MeshEncoding& encoding, void* vertexOut, void* indexOut)>;
+
+    VertexPrecision mPrecision;
+    // NOTE: Shared by every mesh, deleted with the model
+    unsigned mVAO;
+    unsigned mVBO;
+    unsigned mEBO;
+    bool mCooked;
+    size_t mVertexBytes;
+    size_t mIndexBytes;
+    glm::vec3 mBoundsMin;
+    glm::vec3 mBoundsMax;
+
+    /**
+     * @brief Maps the cooked model. At full precision its vertex and index
+     * blobs are uploaded with one glBufferData each, shared by all meshes,
+     * compact models convert them through upload
+     *
+     * @param pool Workers for the conversion
+     *
+     * @returns true - Loaded, false - Missing, stale or corrupt, use Assimp
+     */
+    bool loadCooked(ThreadPool& pool);
+
+    /**
+     * @brief Lays meshes out in one vertex and one index buffer, in the
+     * model's vertex format, and fills them with one job per mesh
+     *
+     * @param pool Workers running write
+     * @param entries FirstVertex and VertexCount of every mesh, the rest may be filled in by write
+     * @param indexCapacities Most indices each mesh may write
+     * @param write Job body
+     */
+    void upload(ThreadPool& pool, std::vector<CookedModelMesh>& entries, const std::vector<size_t>& indexCapacities, const MeshWriter& write);
 };
 
 #define MESH_HP
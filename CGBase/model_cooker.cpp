@@ -0,0 +1,113 @@
+#include "model_cooker.hpp"
+#include "cooked_model.hpp"
+#include "model.hpp"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <algorithm>
+
+static size_t
+alignBlob(size_t offset) {
+    return (offset + COOKED_MODEL_BLOB_ALIGNMENT - 1) / COOKED_MODEL_BLOB_ALIGNMENT * COOKED_MODEL_BLOB_ALIGNMENT;
+}
+
+// NOTE: Truncates, names and paths longer than the fixed fields are rare enough to warn about
+static void
+copyName(char* out, size_t length, const std::string& name, const std::string& sourcePath) {
+    if (name.size() >= length) {
+        std::cerr << "[Warn] " << sourcePath << ": truncating " << name << std::endl;
+    }
+    size_t Count = std::min(name.size(), length - 1);
+    memcpy(out, name.data(), Count);
+    out[Count] = 0;
+}
+
+ModelCooker::ModelCooker()
+    : mCookedBytes(0) {}
+
+bool
+ModelCooker::Cook(const std::string& sourcePath, const std::string& cookedPath) {
+    Assimp::Importer Importer;
+    const aiScene* Scene = Importer.ReadFile(sourcePath, POSTPROCESS_FLAGS);
+    if (!Scene || Scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !Scene->mRootNode || !Scene->mNumMeshes) {
+        std::cerr << "[Err] Failed to import " << sourcePath << ": " << Importer.GetErrorString() << std::endl;
+        return false;
+    }
+
+    // NOTE: Same processing as an Assimp load, so both paths produce identical meshes
+    std::vector<CookedModelMesh> Meshes(Scene->mNumMeshes);
+    std::vector<MeshOptimizerStats> Stats(Meshes.size());
+    std::vector<MeshVertex> Vertices;
+    std::vector<unsigned> Indices;
+    std::vector<MeshVertex> MeshVertices;
+    std::vector<unsigned> MeshIndices;
+    for (unsigned MeshIdx = 0; MeshIdx < Scene->mNumMeshes; ++MeshIdx) {
+        Meshes[MeshIdx].FirstVertex = (uint32_t)Vertices.size();
+        Meshes[MeshIdx].FirstIndex = (uint32_t)Indices.size();
+        Stats[MeshIdx] = Mesh::Process(Scene->mMeshes[MeshIdx], MeshVertices, MeshIndices, Meshes[MeshIdx]);
+        Vertices.insert(Vertices.end(), MeshVertices.begin(), MeshVertices.end());
+        Indices.insert(Indices.end(), MeshIndices.begin(), MeshIndices.end());
+    }
+
+    std::vector<CookedModelMaterial> Materials(Scene->mNumMaterials);
+    for (unsigned MaterialIdx = 0; MaterialIdx < Scene->mNumMaterials; ++MaterialIdx) {
+        const aiMaterial* Source = Scene->mMaterials[MaterialIdx];
+        aiString Name;
+        aiString Diffuse;
+        Source->Get(AI_MATKEY_NAME, Name);
+        if (Source->GetTextureCount(aiTextureType_DIFFUSE)) {
+            Source->GetTexture(aiTextureType_DIFFUSE, 0, &Diffuse);
+        }
+        copyName(Materials[MaterialIdx].Name, COOKED_MODEL_NAME_LENGTH, Name.C_Str(), sourcePath);
+        copyName(Materials[MaterialIdx].DiffusePath, COOKED_MODEL_PATH_LENGTH, Diffuse.C_Str(), sourcePath);
+    }
+
+    CookedModelHeader Header = { COOKED_MODEL_MAGIC, COOKED_MODEL_VERSION, sizeof(MeshVertex), (uint32_t)Meshes.size(),
+        (uint32_t)Materials.size(), 0, (uint32_t)(Vertices.size() * sizeof(MeshVertex)), 0, (uint32_t)(Indices.size() * sizeof(unsigned)) };
+    size_t TableEnd = sizeof(Header) + Meshes.size() * sizeof(CookedModelMesh) + Materials.size() * sizeof(CookedModelMaterial);
+    Header.VertexOffset = (uint32_t)alignBlob(TableEnd);
+    Header.IndexOffset = (uint32_t)alignBlob((size_t)Header.VertexOffset + Header.VertexSize);
+
+    std::error_code Error;
+    std::filesystem::create_directories(std::filesystem::path(cookedPath).parent_path(), Error);
+    std::ofstream Out(cookedPath, std::ios::binary | std::ios::trunc);
+    if (!Out) {
+        std::cerr << "[Err] Failed to write " << cookedPath << std::endl;
+        return false;
+    }
+
+    Out.write((const char*)&Header, sizeof(Header));
+    Out.write((const char*)Meshes.data(), Meshes.size() * sizeof(CookedModelMesh));
+    Out.write((const char*)Materials.data(), Materials.size() * sizeof(CookedModelMaterial));
+    std::vector<char> Padding(Header.VertexOffset - TableEnd, 0);
+    Out.write(Padding.data(), Padding.size());
+    Out.write((const char*)Vertices.data(), Header.VertexSize);
+    Padding.assign(Header.IndexOffset - ((size_t)Header.VertexOffset + Header.VertexSize), 0);
+    Out.write(Padding.data(), Padding.size());
+    Out.write((const char*)Indices.data(), Header.IndexSize);
+
+    size_t CookedBytes = (size_t)Header.IndexOffset + Header.IndexSize;
+    mCookedBytes += CookedBytes;
+    std::cout << "Cooked " << sourcePath << " -> " << cookedPath << " (" << Meshes.size() << " meshes, " << Vertices.size()
+        << " vertices, " << Indices.size() / 3 << " triangles, " << CookedBytes / 1024 << " KB)" << std::endl;
+    for (unsigned MeshIdx = 0; MeshIdx < Stats.size(); ++MeshIdx) {
+        std::cout << "  mesh " << MeshIdx << ": " << FormatMeshOptimizerStats(Stats[MeshIdx]) << std::endl;
+    }
+    return true;
+}
+
+unsigned
+ModelCooker::CookDirectory(const std::string& directory) {
+    static const std::vector<std::string> SOURCE_EXTENSIONS = { ".obj", ".fbx", ".dae", ".gltf", ".glb", ".3ds" };
+    unsigned Cooked = 0;
+    for (const std::string& SourcePath : FindFilesWithExtensions(directory, SOURCE_EXTENSIONS)) {
+        Cooked += Cook(SourcePath, GetCookedModelPath(SourcePath));
+    }
+    return Cooked;
+}
+
+size_t
+ModelCooker::GetCookedBytes() const {
+    return mCookedBytes;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file model_cooker.hpp
+ * @brief Offline conversion of source models into cooked models: imported
+ * once with Assimp, triangulated and interleaved, written as blobs
+ *
+ */
+
+#pragma once
+#include <string>
+#include <cstddef>
+
+class ModelCooker {
+public:
+    ModelCooker();
+
+    /**
+     * @brief Cooks one model
+     *
+     * @param sourcePath Source model path
+     * @param cookedPath Output path, directories are created as needed
+     *
+     * @returns true - Success, false - Failure
+     */
+    bool Cook(const std::string& sourcePath, const std::string& cookedPath);
+
+    /**
+     * @brief Cooks every model under directory (recursively) to
+     * GetCookedModelPath of its path
+     *
+     * @param directory Directory, relative to the working directory
+     *
+     * @returns Number of models cooked
+     */
+    unsigned CookDirectory(const std::string& directory);
+
+    /**
+     * @brief Size of everything cooked so far
+     *
+     */
+    size_t GetCookedBytes() const;
+private:
+    size_t mCookedBytes;
+};
@@ -0,0 +1,178 @@
+#include "program_cache.hpp"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+static const uint32_t PROGRAM_CACHE_MAGIC = 0x31505347; // "GSP1"
+
+bool ProgramCache::sLoadEnabled = true;
+
+struct ProgramCacheHeader {
+    uint32_t Magic;
+    uint32_t Format;
+    uint64_t Key;
+    uint32_t Length;
+    uint32_t Padding;
+};
+
+static uint64_t
+hashBytes(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* Bytes = (const unsigned char*)data;
+    for (size_t ByteIdx = 0; ByteIdx < size; ++ByteIdx) {
+        hash ^= Bytes[ByteIdx];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static uint64_t
+hashString(uint64_t hash, const char* str) {
+    if (!str) {
+        return hash;
+    }
+    // NOTE: Include terminator so "ab"+"c" and "a"+"bc" differ
+    return hashBytes(hash, str, std::char_traits<char>::length(str) + 1);
+}
+
+bool
+ProgramCache::IsSupported() {
+    if (!GLEW_ARB_get_program_binary) {
+        return false;
+    }
+    int FormatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &FormatCount);
+    return FormatCount > 0;
+}
+
+uint64_t
+ProgramCache::MakeKey(const std::string& vShaderSource, const std::string& fShaderSource) {
+    uint64_t Hash = 14695981039346656037ull;
+    Hash = hashString(Hash, vShaderSource.c_str());
+    Hash = hashString(Hash, fShaderSource.c_str());
+    Hash = hashString(Hash, (const char*)glGetString(GL_VENDOR));
+    Hash = hashString(Hash, (const char*)glGetString(GL_RENDERER));
+    Hash = hashString(Hash, (const char*)glGetString(GL_VERSION));
+    return Hash;
+}
+
+unsigned
+ProgramCache::Load(uint64_t key) {
+    if (!sLoadEnabled || !IsSupported()) {
+        return 0;
+    }
+
+    std::ifstream In(entryPath(key), std::ios::binary);
+    if (!In) {
+        return 0;
+    }
+
+    ProgramCacheHeader Header;
+    if (!In.read((char*)&Header, sizeof(Header)) || Header.Magic != PROGRAM_CACHE_MAGIC || Header.Key != key) {
+        return 0;
+    }
+
+    std::vector<char> Binary(Header.Length);
+    if (!In.read(Binary.data(), Binary.size())) {
+        return 0;
+    }
+
+    unsigned ProgramID = glCreateProgram();
+    glProgramBinary(ProgramID, Header.Format, Binary.data(), (GLsizei)Binary.size());
+    int Success;
+    glGetProgramiv(ProgramID, GL_LINK_STATUS, &Success);
+    if (!Success) {
+        // NOTE: Driver rejected the binary (e.g. updated in place), fall back to compiling
+        glDeleteProgram(ProgramID);
+        std::remove(entryPath(key).c_str());
+        return 0;
+    }
+
+    // NOTE: Modification time doubles as last use for Prune
+    std::error_code Error;
+    std::filesystem::last_write_time(entryPath(key), std::filesystem::file_time_type::clock::now(), Error);
+    return ProgramID;
+}
+
+void
+ProgramCache::Prune() {
+    struct Entry {
+        std::filesystem::path Path;
+        std::filesystem::file_time_type Time;
+        uintmax_t Size;
+    };
+
+    std::vector<Entry> Entries;
+    uint64_t TotalBytes = 0;
+    auto Now = std::filesystem::file_time_type::clock::now();
+    auto MaxAge = std::chrono::hours(24 * PROGRAM_CACHE_MAX_AGE_DAYS);
+    std::error_code Error;
+    for (const auto& File : std::filesystem::directory_iterator(PROGRAM_CACHE_PATH, Error)) {
+        if (!File.is_regular_file(Error) || File.path().extension() != ".bin") {
+            continue;
+        }
+
+        Entry Found = { File.path(), File.last_write_time(Error), 0 };
+        Found.Size = File.file_size(Error);
+        if (Error) {
+            continue;
+        }
+        if (Now - Found.Time > MaxAge) {
+            std::filesystem::remove(Found.Path, Error);
+            continue;
+        }
+        TotalBytes += Found.Size;
+        Entries.push_back(Found);
+    }
+
+    std::sort(Entries.begin(), Entries.end(), [](const Entry& a, const Entry& b) { return a.Time > b.Time; });
+    while (TotalBytes > PROGRAM_CACHE_MAX_BYTES && !Entries.empty()) {
+        std::filesystem::remove(Entries.back().Path, Error);
+        TotalBytes -= Entries.back().Size;
+        Entries.pop_back();
+    }
+}
+
+void
+ProgramCache::SetLoadEnabled(bool enabled) {
+    sLoadEnabled = enabled;
+}
+
+void
+ProgramCache::Store(uint64_t key, unsigned program) {
+    if (!program || !IsSupported()) {
+        return;
+    }
+
+    int Length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &Length);
+    if (Length <= 0) {
+        return;
+    }
+
+    std::vector<char> Binary(Length);
+    GLenum Format = 0;
+    glGetProgramBinary(program, Length, &Length, &Format, Binary.data());
+
+    std::error_code Error;
+    std::filesystem::create_directories(PROGRAM_CACHE_PATH, Error);
+    std::ofstream Out(entryPath(key), std::ios::binary | std::ios::trunc);
+    if (!Out) {
+        std::cerr << "[Warn] Failed to write program cache entry " << entryPath(key) << std::endl;
+        return;
+    }
+
+    ProgramCacheHeader Header = { PROGRAM_CACHE_MAGIC, Format, key, (uint32_t)Length, 0 };
+    Out.write((const char*)&Header, sizeof(Header));
+    Out.write(Binary.data(), Length);
+}
+
+std::string
+ProgramCache::entryPath(uint64_t key) {
+    char Name[32];
+    std::snprintf(Name, sizeof(Name), "%016llx.bin", (unsigned long long)key);
+    return PROGRAM_CACHE_PATH + Name;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file program_cache.hpp
+ * @brief On-disk cache of linked shader program binaries
+ *
+ */
+
+#pragma once
+#include <string>
+#include <cstdint>
+#include <GL/glew.h>
+
+static const std::string PROGRAM_CACHE_PATH = "shader_cache/";
+// NOTE: Entries unused for this long, or the least recently used ones past
+// the size cap, are removed by Prune. One program binary is 10-100 KB
+static const uint64_t PROGRAM_CACHE_MAX_BYTES = 64ull * 1024 * 1024;
+static const unsigned PROGRAM_CACHE_MAX_AGE_DAYS = 30;
+
+class ProgramCache {
+public:
+    /**
+     * @brief Checks whether the driver can hand out program binaries
+     *
+     * @returns true - Supported, false - Not supported
+     */
+    static bool IsSupported();
+
+    /**
+     * @brief Builds cache key from shader sources and driver identity.
+     * Any driver update or source edit yields a new key
+     *
+     * @param vShaderSource Vertex shader source
+     * @param fShaderSource Fragment shader source
+     *
+     * @returns 64-bit key
+     */
+    static uint64_t MakeKey(const std::string& vShaderSource, const std::string& fShaderSource);
+
+    /**
+     * @brief Creates program from cached binary
+     *
+     * @param key Cache key
+     *
+     * @returns Linked program ID or 0 if the entry is missing or stale
+     */
+    static unsigned Load(uint64_t key);
+
+    /**
+     * @brief Removes entries older than PROGRAM_CACHE_MAX_AGE_DAYS, then
+     * the least recently used ones until the cache fits PROGRAM_CACHE_MAX_BYTES.
+     * Load refreshes an entry's modification time
+     */
+    static void Prune();
+
+    /**
+     * @brief Makes Load miss while still letting Store write, to time
+     * startup without the cache
+     *
+     * @param enabled false - Load always misses
+     */
+    static void SetLoadEnabled(bool enabled);
+
+    /**
+     * @brief Writes linked program binary to cache. Program should be
+     * linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+     *
+     * @param key Cache key
+     * @param program Linked program ID
+     */
+    static void Store(uint64_t key, unsigned program);
+private:
+    static bool sLoadEnabled;
+
+    static std::string entryPath(uint64_t key);
+};
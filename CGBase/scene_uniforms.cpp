@@ -0,0 +1,138 @@
+#include "scene_uniforms.hpp"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+// NOTE: One step of an 8-bit color channel
+static const float LIGHT_CUTOFF_INTENSITY = 1.0f / 256.0f;
+
+float
+GetLightRadius(const LightData& light) {
+    glm::vec3 Peak = light.Ka + light.Kd + light.Ks;
+    float MaxIntensity = std::max(Peak.x, std::max(Peak.y, Peak.z));
+    if (MaxIntensity <= 0.0f) {
+        return 0.0f;
+    }
+
+    // NOTE: Solve Kq * d^2 + Kl * d + Kc = MaxIntensity / Cutoff for d
+    float C = light.Kc - MaxIntensity / LIGHT_CUTOFF_INTENSITY;
+    if (light.Kq > 0.0f) {
+        return (-light.Kl + std::sqrt(light.Kl * light.Kl - 4.0f * light.Kq * C)) / (2.0f * light.Kq);
+    }
+    if (light.Kl > 0.0f) {
+        return -C / light.Kl;
+    }
+    return -1.0f;
+}
+
+bool
+SpotlightReachesSphere(const LightData& spotlight, const glm::vec3& center, float radius) {
+    glm::vec3 ToCenter = center - spotlight.Position;
+    float Distance = glm::length(ToCenter);
+    if (Distance <= radius) {
+        return true;
+    }
+
+    float LightRadius = GetLightRadius(spotlight);
+    if (LightRadius >= 0.0f && Distance - radius > LightRadius) {
+        return false;
+    }
+
+    float DirectionLength = glm::length(spotlight.Direction);
+    if (DirectionLength <= 0.0f) {
+        return true;
+    }
+
+    // NOTE: Angle to the sphere center minus the angle the sphere spans
+    float CosToCenter = glm::dot(ToCenter, spotlight.Direction) / (Distance * DirectionLength);
+    float AngleToCenter = std::acos(std::min(1.0f, std::max(-1.0f, CosToCenter)));
+    float SphereAngle = std::asin(radius / Distance);
+    float ConeAngle = std::acos(std::min(1.0f, std::max(-1.0f, spotlight.OuterCutOff)));
+    return AngleToCenter - SphereAngle <= ConeAngle;
+}
+
+static bool
+validateMembers(unsigned program, const std::string& prefix, unsigned baseOffset, const UniformBlockMember* members, unsigned count) {
+    bool Valid = true;
+    for (unsigned MemberIdx = 0; MemberIdx < count; ++MemberIdx) {
+        const UniformBlockMember& Member = members[MemberIdx];
+        std::string Name = prefix + Member.Name;
+        if (Member.Nested) {
+            Valid = validateMembers(program, Name + ".", baseOffset + Member.Offset, Member.Nested, Member.NestedCount) && Valid;
+            continue;
+        }
+
+        const char* NamePtr = Name.c_str();
+        unsigned Index = GL_INVALID_INDEX;
+        glGetUniformIndices(program, 1, &NamePtr, &Index);
+        if (Index == GL_INVALID_INDEX) {
+            std::cerr << "[Err] Uniform block member " << Name << " is missing in the shader" << std::endl;
+            Valid = false;
+            continue;
+        }
+
+        int Offset = -1;
+        int Type = 0;
+        glGetActiveUniformsiv(program, 1, &Index, GL_UNIFORM_OFFSET, &Offset);
+        glGetActiveUniformsiv(program, 1, &Index, GL_UNIFORM_TYPE, &Type);
+        if ((unsigned)Offset != baseOffset + Member.Offset || (GLenum)Type != Member.Type) {
+            std::cerr << "[Err] Uniform block member " << Name << " is at offset " << Offset << " in the shader, "
+                << baseOffset + Member.Offset << " in C++, or its type differs" << std::endl;
+            Valid = false;
+        }
+    }
+    return Valid;
+}
+
+bool
+ValidateUniformBlock(unsigned program, const char* blockName, const UniformBlockMember* members, unsigned count) {
+    if (glGetUniformBlockIndex(program, blockName) == GL_INVALID_INDEX) {
+        return true;
+    }
+    return validateMembers(program, "", 0, members, count);
+}
+
+SceneUniforms::SceneUniforms()
+    : Frame(), Lights() {
+    int OffsetAlignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &OffsetAlignment);
+    if (OffsetAlignment < 1) {
+        OffsetAlignment = 256;
+    }
+
+    // NOTE: Both blocks live in one buffer so a frame costs one upload
+    mLightOffset = ((sizeof(FrameBlock) + OffsetAlignment - 1) / OffsetAlignment) * OffsetAlignment;
+    mStaging.resize(mLightOffset + sizeof(LightBlock));
+
+    glGenBuffers(1, &mUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, mUBO);
+    glBufferData(GL_UNIFORM_BUFFER, mStaging.size(), 0, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, mUBO, 0, sizeof(FrameBlock));
+    glBindBufferRange(GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, mUBO, mLightOffset, sizeof(LightBlock));
+}
+
+SceneUniforms::~SceneUniforms() {
+    glDeleteBuffers(1, &mUBO);
+}
+
+void
+SceneUniforms::Upload() {
+    // NOTE: Negative radius (never fades out) stays negative when squared this way
+    for (unsigned LightIdx = 0; LightIdx < MAX_POINT_LIGHTS; ++LightIdx) {
+        float Radius = GetLightRadius(Lights.PointLights[LightIdx]);
+        Lights.RadiiSq[LightIdx] = Radius * std::abs(Radius);
+    }
+    float SpotlightRadius = GetLightRadius(Lights.Spotlight);
+    Lights.RadiiSq.w = SpotlightRadius * std::abs(SpotlightRadius);
+
+    std::memcpy(mStaging.data(), &Frame, sizeof(FrameBlock));
+    std::memcpy(mStaging.data() + mLightOffset, &Lights, sizeof(LightBlock));
+
+    glBindBuffer(GL_UNIFORM_BUFFER, mUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, mStaging.size(), mStaging.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,209 @@
+/**
+ * @file scene_uniforms.hpp
+ * @brief Per-frame and per-light uniform blocks shared by all shader programs
+ *
+ */
+
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+enum EUniformBlockBinding {
+    FRAME_BLOCK_BINDING = 0,
+    LIGHT_BLOCK_BINDING = 1,
+};
+
+static const char* const FRAME_BLOCK_NAME = "FrameBlock";
+static const char* const LIGHT_BLOCK_NAME = "LightBlock";
+static const unsigned MAX_POINT_LIGHTS = 3;
+
+/**
+ * @brief Mirrors FrameBlock declared in the shaders (std140)
+ */
+struct FrameBlock {
+    glm::mat4 Projection;
+    glm::mat4 View;
+    glm::vec3 ViewPos;
+    float Padding;
+};
+
+/**
+ * @brief Mirrors struct Light in the shaders (std140). Every vec3 is
+ * followed by a float so it packs into a single 16 byte slot.
+ * Unused fields for a light type are left at 0
+ */
+struct LightData {
+    glm::vec3 Position;
+    float Kc;
+    glm::vec3 Direction;
+    float Kl;
+    glm::vec3 Ka;
+    float Kq;
+    glm::vec3 Kd;
+    float InnerCutOff;
+    glm::vec3 Ks;
+    float OuterCutOff;
+};
+
+/**
+ * @brief Mirrors LightBlock in the shaders (std140)
+ */
+struct LightBlock {
+    LightData DirLight;
+    LightData PointLights[MAX_POINT_LIGHTS];
+    LightData Spotlight;
+    // NOTE: Squared GetLightRadius of each point light, spotlight in w.
+    // Filled in by SceneUniforms::Upload
+    glm::vec4 RadiiSq;
+};
+
+static_assert(sizeof(FrameBlock) == 144, "FrameBlock must match std140 layout");
+static_assert(sizeof(LightData) == 80, "LightData must match std140 layout");
+static_assert(offsetof(LightData, Ks) == 64, "LightData must match std140 layout");
+static_assert(MAX_POINT_LIGHTS < 4, "Point light radii are packed into one vec4 with the spotlight");
+static_assert(sizeof(LightBlock) == 80 * (2 + MAX_POINT_LIGHTS) + 16, "LightBlock must match std140 layout");
+
+/**
+ * @brief GLSL type of a C++ block member and its std140 base alignment
+ */
+template<typename T> struct Std140Type;
+template<> struct Std140Type<float> { static constexpr GLenum TYPE = GL_FLOAT; static constexpr unsigned ALIGNMENT = 4; };
+template<> struct Std140Type<glm::vec3> { static constexpr GLenum TYPE = GL_FLOAT_VEC3; static constexpr unsigned ALIGNMENT = 16; };
+template<> struct Std140Type<glm::vec4> { static constexpr GLenum TYPE = GL_FLOAT_VEC4; static constexpr unsigned ALIGNMENT = 16; };
+template<> struct Std140Type<glm::mat4> { static constexpr GLenum TYPE = GL_FLOAT_MAT4; static constexpr unsigned ALIGNMENT = 16; };
+
+/**
+ * @brief One member of a uniform block, named as the shaders declare it.
+ * Struct members have Type 0 and list their own members in Nested
+ */
+struct UniformBlockMember {
+    const char* Name;
+    GLenum Type;
+    unsigned Offset;
+    unsigned Size;
+    unsigned Alignment;
+    const UniformBlockMember* Nested;
+    unsigned NestedCount;
+};
+
+#define UNIFORM_BLOCK_MEMBER(Block, Field, Name) \
+    UniformBlockMember{ Name, Std140Type<decltype(Block::Field)>::TYPE, (unsigned)offsetof(Block, Field), \
+        (unsigned)sizeof(Block::Field), Std140Type<decltype(Block::Field)>::ALIGNMENT, nullptr, 0 }
+#define UNIFORM_BLOCK_STRUCT(Block, Field, Name, Members) \
+    UniformBlockMember{ Name, 0, (unsigned)offsetof(Block, Field), (unsigned)sizeof(LightData), 16, \
+        Members, (unsigned)(sizeof(Members) / sizeof(Members[0])) }
+
+/**
+ * @brief Checks std140 rules that a C++ mirror can break: every member
+ * sits on its base alignment and none overlaps the one before it
+ */
+template<size_t N>
+constexpr bool
+IsStd140Layout(const UniformBlockMember (&members)[N]) {
+    for (size_t MemberIdx = 0; MemberIdx < N; ++MemberIdx) {
+        if (members[MemberIdx].Offset % members[MemberIdx].Alignment) {
+            return false;
+        }
+        if (MemberIdx && members[MemberIdx].Offset < members[MemberIdx - 1].Offset + members[MemberIdx - 1].Size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr UniformBlockMember FRAME_BLOCK_MEMBERS[] = {
+    UNIFORM_BLOCK_MEMBER(FrameBlock, Projection, "uProjection"),
+    UNIFORM_BLOCK_MEMBER(FrameBlock, View, "uView"),
+    UNIFORM_BLOCK_MEMBER(FrameBlock, ViewPos, "uViewPos"),
+};
+
+constexpr UniformBlockMember LIGHT_DATA_MEMBERS[] = {
+    UNIFORM_BLOCK_MEMBER(LightData, Position, "Position"),
+    UNIFORM_BLOCK_MEMBER(LightData, Kc, "Kc"),
+    UNIFORM_BLOCK_MEMBER(LightData, Direction, "Direction"),
+    UNIFORM_BLOCK_MEMBER(LightData, Kl, "Kl"),
+    UNIFORM_BLOCK_MEMBER(LightData, Ka, "Ka"),
+    UNIFORM_BLOCK_MEMBER(LightData, Kq, "Kq"),
+    UNIFORM_BLOCK_MEMBER(LightData, Kd, "Kd"),
+    UNIFORM_BLOCK_MEMBER(LightData, InnerCutOff, "InnerCutOff"),
+    UNIFORM_BLOCK_MEMBER(LightData, Ks, "Ks"),
+    UNIFORM_BLOCK_MEMBER(LightData, OuterCutOff, "OuterCutOff"),
+};
+
+constexpr UniformBlockMember LIGHT_BLOCK_MEMBERS[] = {
+    UNIFORM_BLOCK_STRUCT(LightBlock, DirLight, "uDirLight", LIGHT_DATA_MEMBERS),
+    UNIFORM_BLOCK_STRUCT(LightBlock, PointLights[0], "uPointLights[0]", LIGHT_DATA_MEMBERS),
+    UNIFORM_BLOCK_STRUCT(LightBlock, PointLights[1], "uPointLights[1]", LIGHT_DATA_MEMBERS),
+    UNIFORM_BLOCK_STRUCT(LightBlock, PointLights[2], "uPointLights[2]", LIGHT_DATA_MEMBERS),
+    UNIFORM_BLOCK_STRUCT(LightBlock, Spotlight, "uSpotlight", LIGHT_DATA_MEMBERS),
+    UNIFORM_BLOCK_MEMBER(LightBlock, RadiiSq, "uLightRadiiSq"),
+};
+
+static_assert(IsStd140Layout(FRAME_BLOCK_MEMBERS), "FrameBlock breaks std140 layout");
+static_assert(IsStd140Layout(LIGHT_DATA_MEMBERS), "LightData breaks std140 layout");
+static_assert(IsStd140Layout(LIGHT_BLOCK_MEMBERS), "LightBlock breaks std140 layout");
+static_assert(sizeof(LIGHT_BLOCK_MEMBERS) / sizeof(LIGHT_BLOCK_MEMBERS[0]) == MAX_POINT_LIGHTS + 3, "LightBlock description must list every light");
+
+/**
+ * @brief Compares a program's reflected block layout with its C++
+ * description and logs every mismatch. Debug builds only
+ *
+ * @param program Linked program ID
+ * @param blockName Block name, as declared in the shaders
+ * @param members C++ description of the block
+ * @param count Number of members
+ *
+ * @returns true - Layouts match (or program doesn't use the block), false - Mismatch
+ */
+bool ValidateUniformBlock(unsigned program, const char* blockName, const UniformBlockMember* members, unsigned count);
+
+/**
+ * @brief Distance past which an attenuated light contributes less than
+ * one 8-bit step of color, derived from Kc, Kl and Kq
+ *
+ * @param light Point light or spotlight
+ *
+ * @returns Radius in world units, or a negative value if the light never fades out
+ */
+float GetLightRadius(const LightData& light);
+
+/**
+ * @brief Conservative test whether any point of a sphere can be lit by
+ * a spotlight, taking both the cone and the light radius into account
+ *
+ * @param spotlight Spotlight
+ * @param center Sphere center in world space
+ * @param radius Sphere radius
+ *
+ * @returns true - May be lit, false - Certainly unlit
+ */
+bool SpotlightReachesSphere(const LightData& spotlight, const glm::vec3& center, float radius);
+
+class SceneUniforms {
+public:
+    FrameBlock Frame;
+    LightBlock Lights;
+
+    /**
+     * @brief Ctor - creates one uniform buffer holding both blocks and
+     * binds them to FRAME_BLOCK_BINDING and LIGHT_BLOCK_BINDING
+     *
+     */
+    SceneUniforms();
+    ~SceneUniforms();
+    SceneUniforms(const SceneUniforms&) = delete;
+    SceneUniforms& operator=(const SceneUniforms&) = delete;
+
+    /**
+     * @brief Derives light radii, then uploads Frame and Lights with a
+     * single glBufferSubData
+     *
+     */
+    void Upload();
+private:
+    unsigned mUBO;
+    unsigned mLightOffset;
+    std::vector<unsigned char> mStaging;
+};
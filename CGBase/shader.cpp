@@ -1,10 +1,353 @@
 #include "shader.hpp"
+#include "scene_uniforms.hpp"
+#include "program_cache.hpp"
+#include <chrono>
+#include <algorithm>
+#include <cmath>
 
 
-Shader::Shader(const std::string& vShaderPath, const std::string& fShaderPath) {
-    unsigned vs = loadAndCompileShader(vShaderPath, GL_VERTEX_SHADER);
-    unsigned fs = loadAndCompileShader(fShaderPath, GL_FRAGMENT_SHADER);
-    mId = createBasicProgram(vs, fs);
+ShaderDefines::ShaderDefines()
+    : mKey(0) {
+    Set("MAX_POINT_LIGHTS", MAX_POINT_LIGHTS);
+}
+
+ShaderDefines&
+ShaderDefines::Set(const std::string& name, int value) {
+    // NOTE: LightBlock is sized by MAX_POINT_LIGHTS on both sides, shaders
+    // must not loop past it or declare a different size
+    if (name == "MAX_POINT_LIGHTS" && value != (int)MAX_POINT_LIGHTS) {
+        std::cerr << "[Warn] MAX_POINT_LIGHTS is fixed at " << MAX_POINT_LIGHTS << ", ignoring " << value << std::endl;
+        value = MAX_POINT_LIGHTS;
+    }
+    if (name == "NUM_POINT_LIGHTS" && (value < 0 || value > (int)MAX_POINT_LIGHTS)) {
+        std::cerr << "[Warn] NUM_POINT_LIGHTS " << value << " clamped to [0, " << MAX_POINT_LIGHTS << "]" << std::endl;
+        value = std::min(std::max(value, 0), (int)MAX_POINT_LIGHTS);
+    }
+
+    auto It = std::lower_bound(mDefines.begin(), mDefines.end(), name,
+        [](const std::pair<std::string, int>& define, const std::string& n) { return define.first < n; });
+    if (It != mDefines.end() && It->first == name) {
+        It->second = value;
+    } else {
+        mDefines.insert(It, std::make_pair(name, value));
+    }
+
+    uint64_t Key = 14695981039346656037ull;
+    for (const auto& Define : mDefines) {
+        for (char C : Define.first) {
+            Key = (Key ^ (uint8_t)C) * 1099511628211ull;
+        }
+        Key = (Key ^ (uint32_t)Define.second) * 1099511628211ull;
+    }
+    mKey = Key;
+    return *this;
+}
+
+uint64_t
+ShaderDefines::GetKey() const {
+    return mKey;
+}
+
+std::string
+ShaderDefines::Inject(const std::string& source) const {
+    if (mDefines.empty()) {
+        return source;
+    }
+
+    // NOTE: #version must stay the first directive. Some files spell it "# version"
+    size_t VersionPos = source.find("version");
+    size_t LineEnd = VersionPos == std::string::npos ? std::string::npos : source.find('\n', VersionPos);
+    size_t InsertPos = LineEnd == std::string::npos ? 0 : LineEnd + 1;
+    int NextLine = 1 + (int)std::count(source.begin(), source.begin() + InsertPos, '\n');
+
+    std::string Prelude;
+    for (const auto& Define : mDefines) {
+        Prelude += "#define " + Define.first + " " + std::to_string(Define.second) + "\n";
+    }
+    // NOTE: Keep compiler error line numbers pointing into the original file
+    Prelude += "#line " + std::to_string(NextLine) + "\n";
+
+    std::string Result = source;
+    Result.insert(InsertPos, Prelude);
+    return Result;
+}
+
+// NOTE: Relative tolerance for treating basis vectors as orthogonal and equally long
+static const float UNIFORM_SCALE_EPSILON = 1e-4f;
+
+glm::mat3
+GetNormalMatrix(const glm::mat4& model) {
+    glm::mat3 Linear(model);
+    float LengthSq0 = glm::dot(Linear[0], Linear[0]);
+    float LengthSq1 = glm::dot(Linear[1], Linear[1]);
+    float LengthSq2 = glm::dot(Linear[2], Linear[2]);
+    float Tolerance = UNIFORM_SCALE_EPSILON * LengthSq0;
+    bool UniformScale = LengthSq0 > 0.0f
+        && std::abs(LengthSq1 - LengthSq0) <= Tolerance
+        && std::abs(LengthSq2 - LengthSq0) <= Tolerance
+        && std::abs(glm::dot(Linear[0], Linear[1])) <= Tolerance
+        && std::abs(glm::dot(Linear[0], Linear[2])) <= Tolerance
+        && std::abs(glm::dot(Linear[1], Linear[2])) <= Tolerance;
+
+    // NOTE: For s * R the inverse transpose is R / s, which is the matrix itself over s^2
+    if (UniformScale) {
+        return Linear * (1.0f / LengthSq0);
+    }
+    return glm::transpose(glm::inverse(Linear));
+}
+
+bool Shader::sParallelCompile = false;
+
+bool
+Shader::InitParallelCompile() {
+    if (GLEW_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        sParallelCompile = true;
+    } else if (GLEW_ARB_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        sParallelCompile = true;
+    }
+    return sParallelCompile;
+}
+
+Shader::Shader(const std::string& vShaderPath, const std::string& fShaderPath, const ShaderDefines& defines, EShaderCompile compile)
+    : mId(0), mModelLocation(-1), mNormalMatrixLocation(-1), mViewLocation(-1), mProjectionLocation(-1),
+    mVShaderPath(vShaderPath), mFShaderPath(fShaderPath), mDefines(defines), mVertexShader(0), mFragmentShader(0),
+    mPendingProgram(0), mCacheKey(0), mPendingKey(0), mPending(false), mReloading(false) {
+    mStartTime = std::chrono::steady_clock::now();
+    unsigned CachedProgram = submitProgram();
+    if (CachedProgram) {
+        mId = CachedProgram;
+        mCacheKey = mPendingKey;
+        finishProgram(true);
+        return;
+    }
+
+    if (compile == SHADER_COMPILE_SYNC) {
+        Wait();
+    }
+}
+
+Shader::~Shader() {
+    discardPending();
+    if (mId) {
+        glDeleteProgram(mId);
+    }
+}
+
+bool
+Shader::IsReady() const {
+    if (!mPending) {
+        return true;
+    }
+    if (!sParallelCompile) {
+        // NOTE: No way to ask without blocking, so report ready and let
+        // Wait() take the hit. Without the extension the driver compiles
+        // when status is queried, on this (the render) thread
+        return true;
+    }
+
+    int Completed = 0;
+    glGetProgramiv(mPendingProgram, GL_COMPLETION_STATUS_KHR, &Completed);
+    return Completed != 0;
+}
+
+void
+Shader::Wait() {
+    if (!mPending) {
+        return;
+    }
+
+    unsigned Program = finishPending();
+    if (mReloading) {
+        mReloading = false;
+        swapProgram(Program, false);
+        return;
+    }
+
+    mId = Program;
+    mCacheKey = Program ? mPendingKey : 0;
+    finishProgram(false);
+}
+
+bool
+Shader::UsesSource(const std::string& fileName) const {
+    auto FileNameOf = [](const std::string& path) {
+        size_t Slash = path.find_last_of("/\\");
+        return Slash == std::string::npos ? path : path.substr(Slash + 1);
+    };
+    return FileNameOf(mVShaderPath) == fileName || FileNameOf(mFShaderPath) == fileName;
+}
+
+void
+Shader::Reload() {
+    if (mPending && !mReloading) {
+        Wait();
+    }
+    // NOTE: A newer edit supersedes a reload that is still compiling
+    discardPending();
+
+    std::cout << "Reloading " << mVShaderPath << " + " << mFShaderPath << std::endl;
+    mStartTime = std::chrono::steady_clock::now();
+    unsigned CachedProgram = submitProgram();
+    if (CachedProgram && CachedProgram == mId) {
+        std::cout << "Sources unchanged, keeping program" << std::endl;
+        return;
+    }
+    if (CachedProgram) {
+        swapProgram(CachedProgram, true);
+        return;
+    }
+    mReloading = true;
+}
+
+bool
+Shader::PollReload() {
+    // NOTE: Without parallel compile support IsReady() is always true, so
+    // the first poll after an edit compiles synchronously and that frame stalls
+    if (!mReloading || !IsReady()) {
+        return false;
+    }
+
+    Wait();
+    return true;
+}
+
+unsigned
+Shader::submitProgram() {
+    std::string VertexSource = mDefines.Inject(readShaderSource(mVShaderPath));
+    std::string FragmentSource = mDefines.Inject(readShaderSource(mFShaderPath));
+
+    // NOTE: Entries of earlier edits stay, reverting one hits them again.
+    // ProgramCache::Prune retires the ones that are no longer used
+    mPendingKey = ProgramCache::MakeKey(VertexSource, FragmentSource);
+    if (mId && mPendingKey == mCacheKey) {
+        return mId;
+    }
+    unsigned CachedProgram = ProgramCache::Load(mPendingKey);
+    if (CachedProgram) {
+        return CachedProgram;
+    }
+
+    // NOTE: Only submit work here. Status queries force the driver to finish, so they wait for Wait()
+    mVertexShader = compileShader(VertexSource, GL_VERTEX_SHADER);
+    mFragmentShader = compileShader(FragmentSource, GL_FRAGMENT_SHADER);
+    mPendingProgram = createBasicProgram(mVertexShader, mFragmentShader);
+    mPending = true;
+    return 0;
+}
+
+unsigned
+Shader::finishPending() {
+    bool Success = checkShader(mVertexShader, GL_VERTEX_SHADER, mVShaderPath);
+    Success = checkShader(mFragmentShader, GL_FRAGMENT_SHADER, mFShaderPath) && Success;
+    Success = Success && checkProgram(mPendingProgram);
+
+    unsigned Program = mPendingProgram;
+    glDetachShader(Program, mVertexShader);
+    glDetachShader(Program, mFragmentShader);
+    glDeleteShader(mVertexShader);
+    glDeleteShader(mFragmentShader);
+    mVertexShader = mFragmentShader = mPendingProgram = 0;
+    mPending = false;
+
+    if (!Success) {
+        glDeleteProgram(Program);
+        return 0;
+    }
+
+    ProgramCache::Store(mPendingKey, Program);
+    return Program;
+}
+
+void
+Shader::discardPending() {
+    if (!mPending) {
+        return;
+    }
+
+    glDeleteShader(mVertexShader);
+    glDeleteShader(mFragmentShader);
+    glDeleteProgram(mPendingProgram);
+    mVertexShader = mFragmentShader = mPendingProgram = 0;
+    mPending = false;
+    mReloading = false;
+}
+
+void
+Shader::swapProgram(unsigned program, bool fromCache) {
+    if (!program) {
+        std::cerr << "[Err] Reload of " << mVShaderPath << " + " << mFShaderPath << " failed, keeping previous program" << std::endl;
+        return;
+    }
+
+    if (mId) {
+        copyUniformState(mId, program);
+        glDeleteProgram(mId);
+    }
+    mId = program;
+    mCacheKey = mPendingKey;
+    finishProgram(fromCache);
+}
+
+void
+Shader::copyUniformState(unsigned fromProgram, unsigned toProgram) {
+    int PreviousProgram = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &PreviousProgram);
+    glUseProgram(toProgram);
+
+    int UniformCount = 0;
+    int MaxNameLength = 0;
+    glGetProgramiv(toProgram, GL_ACTIVE_UNIFORMS, &UniformCount);
+    glGetProgramiv(toProgram, GL_ACTIVE_UNIFORM_MAX_LENGTH, &MaxNameLength);
+    std::vector<char> NameBuffer(MaxNameLength + 1);
+    for (int UniformIdx = 0; UniformIdx < UniformCount; ++UniformIdx) {
+        GLsizei NameLength = 0;
+        GLint Size = 0;
+        GLenum Type = 0;
+        glGetActiveUniform(toProgram, UniformIdx, (GLsizei)NameBuffer.size(), &NameLength, &Size, &Type, NameBuffer.data());
+        std::string Name(NameBuffer.data(), NameLength);
+        if (Size > 1 && Name.size() > 3 && Name.compare(Name.size() - 3, 3, "[0]") == 0) {
+            Name.resize(Name.size() - 3);
+        }
+
+        for (int ElementIdx = 0; ElementIdx < Size; ++ElementIdx) {
+            std::string ElementName = Size > 1 ? Name + "[" + std::to_string(ElementIdx) + "]" : Name;
+            int FromLocation = glGetUniformLocation(fromProgram, ElementName.c_str());
+            int ToLocation = glGetUniformLocation(toProgram, ElementName.c_str());
+            if (FromLocation < 0 || ToLocation < 0) {
+                continue;
+            }
+
+            float Floats[16];
+            int Ints[4];
+            switch (Type) {
+            case GL_FLOAT: glGetUniformfv(fromProgram, FromLocation, Floats); glUniform1fv(ToLocation, 1, Floats); break;
+            case GL_FLOAT_VEC2: glGetUniformfv(fromProgram, FromLocation, Floats); glUniform2fv(ToLocation, 1, Floats); break;
+            case GL_FLOAT_VEC3: glGetUniformfv(fromProgram, FromLocation, Floats); glUniform3fv(ToLocation, 1, Floats); break;
+            case GL_FLOAT_VEC4: glGetUniformfv(fromProgram, FromLocation, Floats); glUniform4fv(ToLocation, 1, Floats); break;
+            case GL_FLOAT_MAT3: glGetUniformfv(fromProgram, FromLocation, Floats); glUniformMatrix3fv(ToLocation, 1, GL_FALSE, Floats); break;
+            case GL_FLOAT_MAT4: glGetUniformfv(fromProgram, FromLocation, Floats); glUniformMatrix4fv(ToLocation, 1, GL_FALSE, Floats); break;
+            case GL_INT:
+            case GL_BOOL:
+            case GL_SAMPLER_2D:
+            case GL_SAMPLER_2D_ARRAY:
+            case GL_SAMPLER_CUBE: glGetUniformiv(fromProgram, FromLocation, Ints); glUniform1iv(ToLocation, 1, Ints); break;
+            default: break;
+            }
+        }
+    }
+
+    glUseProgram(PreviousProgram);
+}
+
+void
+Shader::finishProgram(bool fromCache) {
+    double ElapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStartTime).count();
+    std::cout << (fromCache ? "Loaded cached program " : "Compiled program ") << mVShaderPath << " + " << mFShaderPath
+        << " in " << ElapsedMs << " ms" << std::endl;
+    cacheUniformLocations();
+    bindUniformBlocks();
 }
 
 unsigned
@@ -12,47 +355,241 @@ Shader::GetId() const {
     return mId;
 }
 
+int
+Shader::GetUniformLocation(std::string_view uniform) const {
+    return findUniform(uniform, HashUniformName(uniform));
+}
+
+int
+Shader::GetUniformLocation(const UniformName& uniform) const {
+    return findUniform(uniform.Name, uniform.Hash);
+}
+
+void
+Shader::Set(Uniform<int> uniform, int v) const {
+    checkBound();
+    glUniform1i(uniform.Location, v);
+}
+
+void
+Shader::Set(Uniform<float> uniform, float v) const {
+    checkBound();
+    glUniform1f(uniform.Location, v);
+}
+
+void
+Shader::Set(Uniform<glm::vec3> uniform, const glm::vec3& v) const {
+    checkBound();
+    glUniform3f(uniform.Location, v.x, v.y, v.z);
+}
+
+void
+Shader::Set(Uniform<glm::mat4> uniform, const glm::mat4& m) const {
+    checkBound();
+    glUniformMatrix4fv(uniform.Location, 1, GL_FALSE, &m[0][0]);
+}
+
+void
+Shader::SetUniform1i(std::string_view uniform, int v) const {
+    glUniform1i(GetUniformLocation(uniform), v);
+}
+
 void
-Shader::SetUniform1i(const std::string& uniform, int v) const {
-    glUniform1i(glGetUniformLocation(mId, uniform.c_str()), v);
+Shader::SetUniform1i(const UniformName& uniform, int v) const {
+    glUniform1i(GetUniformLocation(uniform), v);
 }
 
 void
-Shader::SetUniform1f(const std::string& uniform, float v) const {
-    glUniform1f(glGetUniformLocation(mId, uniform.c_str()), v);
+Shader::SetUniform1f(std::string_view uniform, float v) const {
+    glUniform1f(GetUniformLocation(uniform), v);
 }
 
 void
-Shader::SetUniform3f(const std::string& uniform, const glm::vec3& v) const {
-    glUniform3f(glGetUniformLocation(mId, uniform.c_str()), v.x, v.y, v.z);
+Shader::SetUniform1f(const UniformName& uniform, float v) const {
+    glUniform1f(GetUniformLocation(uniform), v);
 }
 
 void
-Shader::SetUniform4m(const std::string& uniform, const glm::mat4& m) const {
-    glUniformMatrix4fv(glGetUniformLocation(mId, uniform.c_str()), 1, GL_FALSE, &m[0][0]);
+Shader::SetUniform3f(std::string_view uniform, const glm::vec3& v) const {
+    glUniform3f(GetUniformLocation(uniform), v.x, v.y, v.z);
+}
+
+void
+Shader::SetUniform3f(const UniformName& uniform, const glm::vec3& v) const {
+    glUniform3f(GetUniformLocation(uniform), v.x, v.y, v.z);
+}
+
+void
+Shader::SetUniform4m(std::string_view uniform, const glm::mat4& m) const {
+    glUniformMatrix4fv(GetUniformLocation(uniform), 1, GL_FALSE, &m[0][0]);
+}
+
+void
+Shader::SetUniform4m(const UniformName& uniform, const glm::mat4& m) const {
+    glUniformMatrix4fv(GetUniformLocation(uniform), 1, GL_FALSE, &m[0][0]);
 }
 
 void
 Shader::SetModel(const glm::mat4& m) const {
-    SetUniform4m("uModel", m);
+    checkBound();
+    glUniformMatrix4fv(mModelLocation, 1, GL_FALSE, &m[0][0]);
+    if (mNormalMatrixLocation >= 0) {
+        glm::mat3 NormalMatrix = GetNormalMatrix(m);
+        glUniformMatrix3fv(mNormalMatrixLocation, 1, GL_FALSE, &NormalMatrix[0][0]);
+    }
 }
 
 void
 Shader::SetView(const glm::mat4& m) const {
-    SetUniform4m("uView", m);
+    checkBound();
+    glUniformMatrix4fv(mViewLocation, 1, GL_FALSE, &m[0][0]);
 }
 
 void Shader::SetProjection(const glm::mat4& m) const {
-    SetUniform4m("uProjection", m);
+    checkBound();
+    glUniformMatrix4fv(mProjectionLocation, 1, GL_FALSE, &m[0][0]);
 }
 
 void Shader::SetColor(const float r, const float g, const float b) {
-    glUniform3f(glGetUniformLocation(mId, "uCol"), r, g, b);
+    glUniform3f(GetUniformLocation("uCol"), r, g, b);
 }
 
-unsigned
-Shader::loadAndCompileShader(std::string filename, GLuint shaderType) {
-    unsigned ShaderID = 0;
+void
+Shader::checkUniformType(std::string_view uniform, GLenum type) const {
+    std::string Name(uniform);
+    const char* NamePtr = Name.c_str();
+    unsigned Index = GL_INVALID_INDEX;
+    glGetUniformIndices(mId, 1, &NamePtr, &Index);
+    if (Index == GL_INVALID_INDEX) {
+        return;
+    }
+
+    int ActualType = 0;
+    glGetActiveUniformsiv(mId, 1, &Index, GL_UNIFORM_TYPE, &ActualType);
+    bool IntLike = ActualType == GL_INT || ActualType == GL_BOOL || ActualType == GL_SAMPLER_2D
+        || ActualType == GL_SAMPLER_2D_ARRAY || ActualType == GL_SAMPLER_CUBE;
+    if ((GLenum)ActualType != type && !(type == GL_INT && IntLike)) {
+        std::cerr << "[Err] Uniform " << Name << " in " << mVShaderPath << " + " << mFShaderPath
+            << " has a different type than its handle" << std::endl;
+    }
+}
+
+void
+Shader::reportIfUnbound() const {
+    int CurrentProgram = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &CurrentProgram);
+    if ((unsigned)CurrentProgram != mId) {
+        std::cerr << "[Err] Setting uniforms of " << mVShaderPath << " + " << mFShaderPath
+            << " while another program is bound" << std::endl;
+    }
+}
+
+void
+Shader::cacheUniformLocations() {
+    mUniformTable.clear();
+    mUniformNames.clear();
+
+    int UniformCount = 0;
+    int MaxNameLength = 0;
+    if (mId) {
+        glGetProgramiv(mId, GL_ACTIVE_UNIFORMS, &UniformCount);
+        glGetProgramiv(mId, GL_ACTIVE_UNIFORM_MAX_LENGTH, &MaxNameLength);
+    }
+
+    // NOTE: Arrays get an extra entry without the "[0]" suffix, keep load under 1/2
+    unsigned TableSize = 16;
+    while (TableSize < (unsigned)UniformCount * 4) {
+        TableSize <<= 1;
+    }
+    mUniformTable.assign(TableSize, UniformSlot{ 0, -1, 0, 0 });
+
+    std::vector<char> NameBuffer(MaxNameLength + 1);
+    for (int UniformIdx = 0; UniformIdx < UniformCount; ++UniformIdx) {
+        GLsizei NameLength = 0;
+        GLint Size = 0;
+        GLenum Type = 0;
+        glGetActiveUniform(mId, UniformIdx, (GLsizei)NameBuffer.size(), &NameLength, &Size, &Type, NameBuffer.data());
+        std::string_view Name(NameBuffer.data(), NameLength);
+        int Location = glGetUniformLocation(mId, NameBuffer.data());
+        // NOTE: Uniforms inside blocks have no location
+        if (Location < 0) {
+            continue;
+        }
+
+        insertUniform(Name, Location);
+        if (Name.size() > 3 && Name.substr(Name.size() - 3) == "[0]") {
+            insertUniform(Name.substr(0, Name.size() - 3), Location);
+        }
+    }
+
+    mModelLocation = GetUniformLocation(MODEL);
+    mNormalMatrixLocation = GetUniformLocation(NORMAL_MATRIX);
+    mViewLocation = GetUniformLocation(VIEW);
+    mProjectionLocation = GetUniformLocation(PROJECTION);
+}
+
+void
+Shader::bindUniformBlocks() {
+    if (!mId) {
+        return;
+    }
+
+    unsigned FrameIndex = glGetUniformBlockIndex(mId, FRAME_BLOCK_NAME);
+    if (FrameIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(mId, FrameIndex, FRAME_BLOCK_BINDING);
+    }
+
+    unsigned LightIndex = glGetUniformBlockIndex(mId, LIGHT_BLOCK_NAME);
+    if (LightIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(mId, LightIndex, LIGHT_BLOCK_BINDING);
+    }
+
+#ifndef NDEBUG
+    bool Valid = ValidateUniformBlock(mId, FRAME_BLOCK_NAME, FRAME_BLOCK_MEMBERS, sizeof(FRAME_BLOCK_MEMBERS) / sizeof(FRAME_BLOCK_MEMBERS[0]));
+    Valid = ValidateUniformBlock(mId, LIGHT_BLOCK_NAME, LIGHT_BLOCK_MEMBERS, sizeof(LIGHT_BLOCK_MEMBERS) / sizeof(LIGHT_BLOCK_MEMBERS[0])) && Valid;
+    if (!Valid) {
+        std::cerr << "[Err] " << mVShaderPath << " + " << mFShaderPath << " disagree with scene_uniforms.hpp" << std::endl;
+    }
+#endif
+}
+
+void
+Shader::insertUniform(std::string_view name, int location) {
+    uint32_t Hash = HashUniformName(name);
+    uint32_t Mask = (uint32_t)mUniformTable.size() - 1;
+    for (uint32_t SlotIdx = Hash & Mask;; SlotIdx = (SlotIdx + 1) & Mask) {
+        UniformSlot& Slot = mUniformTable[SlotIdx];
+        if (!Slot.NameLength) {
+            Slot.Hash = Hash;
+            Slot.Location = location;
+            Slot.NameOffset = (uint32_t)mUniformNames.size();
+            Slot.NameLength = (uint32_t)name.size();
+            mUniformNames.append(name.data(), name.size());
+            return;
+        }
+    }
+}
+
+int
+Shader::findUniform(std::string_view name, uint32_t hash) const {
+    if (mUniformTable.empty()) {
+        return -1;
+    }
+
+    uint32_t Mask = (uint32_t)mUniformTable.size() - 1;
+    for (uint32_t SlotIdx = hash & Mask;; SlotIdx = (SlotIdx + 1) & Mask) {
+        const UniformSlot& Slot = mUniformTable[SlotIdx];
+        if (!Slot.NameLength) {
+            return -1;
+        }
+        if (Slot.Hash == hash && std::string_view(mUniformNames.data() + Slot.NameOffset, Slot.NameLength) == name) {
+            return Slot.Location;
+        }
+    }
+}
+
+std::string
+Shader::readShaderSource(const std::string& filename) {
     std::ifstream In(filename);
     std::string Str;
 
@@ -61,25 +598,34 @@ Shader::loadAndCompileShader(std::string filename, GLuint shaderType) {
     In.seekg(0, std::ios::beg);
 
     Str.assign((std::istreambuf_iterator<char>(In)), std::istreambuf_iterator<char>());
-    const char* CharContent = Str.c_str();
+    return Str;
+}
+
+unsigned
+Shader::compileShader(const std::string& source, GLuint shaderType) {
+    unsigned ShaderID = 0;
+    const char* CharContent = source.c_str();
 
     ShaderID = glCreateShader(shaderType);
     glShaderSource(ShaderID, 1, &CharContent, NULL);
     glCompileShader(ShaderID);
+    return ShaderID;
+}
 
+bool
+Shader::checkShader(unsigned shaderId, GLuint shaderType, const std::string& filename) {
     int Success;
     char InfoLog[512];
-    glGetShaderiv(ShaderID, GL_COMPILE_STATUS, &Success);
+    glGetShaderiv(shaderId, GL_COMPILE_STATUS, &Success);
     if (!Success) {
-        glGetShaderInfoLog(ShaderID, 256, NULL, InfoLog);
+        glGetShaderInfoLog(shaderId, 512, NULL, InfoLog);
         std::string ShaderTypeName = shaderType == GL_VERTEX_SHADER ? "vertex" : "fragment";
-        std::cout << "Error while compiling shader [" << ShaderTypeName << "]:" << std::endl << InfoLog << std::endl;
-        return 0;
+        std::cout << "Error while compiling shader [" << ShaderTypeName << "] " << filename << ":" << std::endl << InfoLog << std::endl;
+        return false;
     }
 
     std::cout << "Loaded " << filename << " shader" << std::endl;
-
-    return ShaderID;
+    return true;
 }
 
 unsigned
@@ -88,21 +634,22 @@ Shader::createBasicProgram(unsigned vShader, unsigned fShader) {
     ProgramID = glCreateProgram();
     glAttachShader(ProgramID, vShader);
     glAttachShader(ProgramID, fShader);
+    if (ProgramCache::IsSupported()) {
+        glProgramParameteri(ProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glLinkProgram(ProgramID);
+    return ProgramID;
+}
 
+bool
+Shader::checkProgram(unsigned programId) {
     int Success;
     char InfoLog[512];
-    glGetProgramiv(ProgramID, GL_LINK_STATUS, &Success);
+    glGetProgramiv(programId, GL_LINK_STATUS, &Success);
     if (!Success) {
-        glGetProgramInfoLog(ProgramID, 512, NULL, InfoLog);
+        glGetProgramInfoLog(programId, 512, NULL, InfoLog);
         std::cerr << "[Err] Failed to link shader program:" << std::endl << InfoLog << std::endl;
-        return 0;
+        return false;
     }
-
-    glDetachShader(ProgramID, vShader);
-    glDetachShader(ProgramID, fShader);
-    glDeleteShader(vShader);
-    glDeleteShader(fShader);
-
-    return ProgramID;
-}
\ No newline at end of file
+    return true;
+}
@@ -2,13 +2,132 @@
 #include <iostream>
 #include <vector>
 #include <fstream>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <chrono>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+/**
+ * @brief FNV-1a hash of a uniform name. Usable at compile time so
+ * frequently used names can be hashed once
+ *
+ * @param name Uniform name
+ *
+ * @returns 32-bit hash
+ */
+constexpr uint32_t
+HashUniformName(std::string_view name) {
+    uint32_t Hash = 2166136261u;
+    for (char C : name) {
+        Hash ^= (uint8_t)C;
+        Hash *= 16777619u;
+    }
+    return Hash;
+}
+
+/**
+ * @brief Uniform name with a precomputed hash. Construct as constexpr
+ * to keep hashing out of the render loop
+ */
+struct UniformName {
+    std::string_view Name;
+    uint32_t Hash;
+
+    constexpr explicit UniformName(std::string_view name)
+        : Name(name), Hash(HashUniformName(name)) {}
+};
+
+/**
+ * @brief Matrix that transforms normals the same way model transforms
+ * positions. Skips the inverse when model only rotates, translates and
+ * scales uniformly
+ *
+ * @param model Model matrix
+ *
+ * @returns Inverse transpose of the upper 3x3 of model
+ */
+glm::mat3 GetNormalMatrix(const glm::mat4& model);
+
+/**
+ * @brief Resolved uniform location, typed by the value it accepts.
+ * Default constructed handles point to location -1, which GL ignores
+ */
+template<typename T>
+struct Uniform {
+    int Location = -1;
+};
+
+/**
+ * @brief GLSL type a Uniform<T> handle can be set to. Only declared for
+ * types Shader::Set accepts, so other handles fail to compile
+ */
+template<typename T> struct UniformType;
+template<> struct UniformType<int> { static constexpr GLenum TYPE = GL_INT; };
+template<> struct UniformType<float> { static constexpr GLenum TYPE = GL_FLOAT; };
+template<> struct UniformType<glm::vec3> { static constexpr GLenum TYPE = GL_FLOAT_VEC3; };
+template<> struct UniformType<glm::mat4> { static constexpr GLenum TYPE = GL_FLOAT_MAT4; };
+
+/**
+ * @brief Set of #defines injected right after #version. Keeps a hash of
+ * its contents so permutation lookup never touches strings
+ */
+class ShaderDefines {
+public:
+    /**
+     * @brief Ctor - starts with MAX_POINT_LIGHTS, which sizes the shaders' LightBlock
+     *
+     */
+    ShaderDefines();
+
+    /**
+     * @brief Adds or replaces a define. NUM_POINT_LIGHTS is clamped to
+     * MAX_POINT_LIGHTS, and MAX_POINT_LIGHTS itself can't change
+     *
+     * @param name Define name
+     * @param value Define value
+     *
+     * @returns This, for chaining
+     */
+    ShaderDefines& Set(const std::string& name, int value);
+
+    /**
+     * @brief Key identifying this set, independent of insertion order
+     */
+    uint64_t GetKey() const;
+
+    /**
+     * @brief Prepends the defines to shader source, after #version
+     *
+     * @param source Shader source
+     *
+     * @returns Source with defines injected
+     */
+    std::string Inject(const std::string& source) const;
+private:
+    // NOTE: Kept sorted by name so equal sets produce equal keys
+    std::vector<std::pair<std::string, int>> mDefines;
+    uint64_t mKey;
+};
+
+enum EShaderCompile {
+    SHADER_COMPILE_SYNC = 0,
+    SHADER_COMPILE_ASYNC = 1,
+};
+
 class Shader {
 public:
     static const unsigned POSITION_LOCATION = 0;
     static const unsigned COLOR_LOCATION = 1;
+
+    static constexpr UniformName MODEL{ "uModel" };
+    static constexpr UniformName NORMAL_MATRIX{ "uNormalMatrix" };
+    static constexpr UniformName VIEW{ "uView" };
+    static constexpr UniformName PROJECTION{ "uProjection" };
+    // NOTE: Only in COMPACT_VERTICES variants, see Mesh::Render
+    static constexpr UniformName POSITION_ORIGIN{ "uPositionOrigin" };
+    static constexpr UniformName POSITION_EXTENT{ "uPositionExtent" };
     unsigned mId;
 
     /**
@@ -16,17 +135,111 @@ public:
      *
      * @param vShaderPath Vertex shader file path
      * @param fShaderPath Fragment shader file path
+     * @param defines Defines injected into both stages
+     * @param compile SHADER_COMPILE_ASYNC only submits the compile and link,
+     * Wait() must be called before the shader is used
      */
-    Shader(const std::string& vShaderPath, const std::string& fShaderPath);
+    Shader(const std::string& vShaderPath, const std::string& fShaderPath, const ShaderDefines& defines = ShaderDefines(),
+        EShaderCompile compile = SHADER_COMPILE_SYNC);
+    ~Shader();
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
     unsigned GetId() const;
 
+    /**
+     * @brief Lets the driver compile on its own threads if it supports
+     * KHR_parallel_shader_compile. Call once after GL init
+     *
+     * @returns true - Driver compiles in parallel, false - Not supported
+     */
+    static bool InitParallelCompile();
+
+    /**
+     * @brief Checks whether an async compile has finished, without blocking.
+     * Without parallel compile support this always reports ready, and the
+     * following Wait() blocks for the whole compile
+     *
+     * @returns true - Wait() won't block, false - Still compiling
+     */
+    bool IsReady() const;
+
+    /**
+     * @brief Finishes an async compile: checks status, caches the binary
+     * and resolves uniforms. No-op once finished
+     */
+    void Wait();
+
+    /**
+     * @brief Checks whether this program is built from given source file
+     *
+     * @param fileName File name, without directory
+     */
+    bool UsesSource(const std::string& fileName) const;
+
+    /**
+     * @brief Rereads sources and submits them for recompiling. The live
+     * program keeps being used until PollReload() swaps it out. Compiling
+     * only happens in the background with KHR_parallel_shader_compile,
+     * otherwise it is synchronous on the render thread inside PollReload()
+     */
+    void Reload();
+
+    /**
+     * @brief Swaps in the reloaded program once it's compiled, copying all
+     * uniform values over. Keeps the previous program if compilation failed.
+     * Call at a frame boundary. Blocks for the compile when the driver lacks
+     * parallel compile support
+     *
+     * @returns true - Reload finished (successfully or not), false - Nothing to do yet
+     */
+    bool PollReload();
+
+    /**
+     * @brief Looks up uniform location in the cached table. Never calls
+     * into GL and never allocates
+     *
+     * @param uniform Name of uniform
+     *
+     * @returns Location or -1 if the program has no such active uniform
+     */
+    int GetUniformLocation(std::string_view uniform) const;
+    int GetUniformLocation(const UniformName& uniform) const;
+
+    /**
+     * @brief Resolves a typed uniform handle. Intended to be called once,
+     * outside of the render loop
+     *
+     * @param uniform Name of uniform
+     *
+     * @returns Uniform handle
+     */
+    template<typename T>
+    Uniform<T> GetUniform(std::string_view uniform) const {
+#ifndef NDEBUG
+        checkUniformType(uniform, UniformType<T>::TYPE);
+#endif
+        return Uniform<T>{ GetUniformLocation(uniform) };
+    }
+
+    /**
+     * @brief Sets uniform value through a resolved handle
+     *
+     * @param uniform Uniform handle
+     * @param v Value
+     */
+    void Set(Uniform<int> uniform, int v) const;
+    void Set(Uniform<float> uniform, float v) const;
+    void Set(Uniform<glm::vec3> uniform, const glm::vec3& v) const;
+    void Set(Uniform<glm::mat4> uniform, const glm::mat4& m) const;
+
     /**
      * @brief Sets int uniform value
      *
      * @param uniform Name of uniform
      * @param v Value
      */
-    void SetUniform1i(const std::string& uniform, int v) const;
+    void SetUniform1i(std::string_view uniform, int v) const;
+    void SetUniform1i(const UniformName& uniform, int v) const;
 
     /**
      * @brief Sets float uniform value
@@ -34,7 +247,8 @@ public:
      * @param uniform Name of uniform
      * @param v Value
      */
-    void SetUniform1f(const std::string& uniform, float v) const;
+    void SetUniform1f(std::string_view uniform, float v) const;
+    void SetUniform1f(const UniformName& uniform, float v) const;
 
     /**
     * @brief Sets float uniform value
@@ -42,17 +256,20 @@ public:
     * @param uniform Name of uniform
     * @param v Value
     */
-    void SetUniform3f(const std::string& uniform, const glm::vec3& v) const;
+    void SetUniform3f(std::string_view uniform, const glm::vec3& v) const;
+    void SetUniform3f(const UniformName& uniform, const glm::vec3& v) const;
     /**
      * @brief Sets 4x4 matrix uniform value
      *
      * @param uniform Name of uniform
      * @param m GLM matrix
      */
-    void SetUniform4m(const std::string& uniform, const glm::mat4& m) const;
+    void SetUniform4m(std::string_view uniform, const glm::mat4& m) const;
+    void SetUniform4m(const UniformName& uniform, const glm::mat4& m) const;
 
     /**
-     * @brief Sets the Model matrix
+     * @brief Sets the Model matrix, and the normal matrix derived from it
+     * if the shader uses one
      *
      * @param m Model matrix
      */
@@ -74,23 +291,170 @@ public:
     //Postavlja uCol;
     void SetColor(const float, const float, const float);
 private:
+    struct UniformSlot {
+        uint32_t Hash;
+        int Location;
+        uint32_t NameOffset;
+        uint32_t NameLength;
+    };
+
+    // NOTE: Open addressing, power of two sized. Empty slots have NameLength 0
+    std::vector<UniformSlot> mUniformTable;
+    // NOTE: All active uniform names, back to back, referenced by slots
+    std::string mUniformNames;
+    int mModelLocation;
+    int mNormalMatrixLocation;
+    int mViewLocation;
+    int mProjectionLocation;
+
+    std::string mVShaderPath;
+    std::string mFShaderPath;
+    ShaderDefines mDefines;
+    // NOTE: Only valid while a compile is pending
+    unsigned mVertexShader;
+    unsigned mFragmentShader;
+    unsigned mPendingProgram;
+    // NOTE: Key of the live program, and of the one last submitted, which
+    // only becomes live once it replaces the other
+    uint64_t mCacheKey;
+    uint64_t mPendingKey;
+    bool mPending;
+    bool mReloading;
+    std::chrono::steady_clock::time_point mStartTime;
+
+    static bool sParallelCompile;
 
     /**
-     * @brief Loads shader from file and returns the compiled shader's ID
+     * @brief Reads whole shader source file
      *
      * @param filename File path to be loaded
+     *
+     * @returns Shader source
+     */
+    std::string readShaderSource(const std::string& filename);
+
+    /**
+     * @brief Submits shader source for compilation, doesn't wait for the result
+     *
+     * @param source Shader source
      * @param shadertType Type of shader: vertex or fragment
      *
-     * @returns Compiled shader's ID
+     * @returns Shader's ID
      */
-    unsigned loadAndCompileShader(std::string filename, GLuint shaderType);
+    unsigned compileShader(const std::string& source, GLuint shaderType);
+
     /**
-     * @brief Creates a shader program and returns the ID
+     * @brief Checks compile status and logs errors. Blocks until compiled
      *
-     * @param filename File path to be loaded
+     * @param shaderId Shader's ID
      * @param shadertType Type of shader: vertex or fragment
+     * @param filename File path the source was loaded from, for logging
+     *
+     * @returns true - Compiled, false - Failed
+     */
+    bool checkShader(unsigned shaderId, GLuint shaderType, const std::string& filename);
+
+    /**
+     * @brief Creates a shader program and submits linking, doesn't wait for the result
+     *
+     * @param vShader Vertex shader ID
+     * @param fShader Fragment shader ID
      *
      * @returns Shader program ID
      */
     unsigned createBasicProgram(unsigned vShader, unsigned fShader);
-};
\ No newline at end of file
+
+    /**
+     * @brief Checks link status and logs errors. Blocks until linked
+     *
+     * @param programId Shader program ID
+     *
+     * @returns true - Linked, false - Failed
+     */
+    bool checkProgram(unsigned programId);
+
+    /**
+     * @brief Reads sources and either loads the program from the binary
+     * cache or submits it for compilation
+     *
+     * @returns Cached program ID, the live one if the sources are unchanged,
+     * or 0 if compilation was submitted
+     */
+    unsigned submitProgram();
+
+    /**
+     * @brief Waits for the submitted compile, checks it and caches the binary
+     *
+     * @returns Program ID, or 0 on failure
+     */
+    unsigned finishPending();
+
+    /**
+     * @brief Drops a submitted compile without waiting for it
+     */
+    void discardPending();
+
+    /**
+     * @brief Replaces the live program with a reloaded one
+     *
+     * @param program Reloaded program ID, 0 keeps the live program
+     * @param fromCache Whether the program came from the binary cache
+     */
+    void swapProgram(unsigned program, bool fromCache);
+
+    /**
+     * @brief Copies values of all uniforms both programs share
+     *
+     * @param fromProgram Source program ID
+     * @param toProgram Destination program ID
+     */
+    void copyUniformState(unsigned fromProgram, unsigned toProgram);
+
+    /**
+     * @brief Logs if the uniform's GLSL type doesn't match the handle. Debug builds only
+     *
+     * @param uniform Name of uniform
+     * @param type Expected GLSL type, GL_INT also accepts bools and samplers
+     */
+    void checkUniformType(std::string_view uniform, GLenum type) const;
+
+    /**
+     * @brief Logs if another program is bound while setting uniforms of
+     * this one. Compiles to nothing in release builds
+     */
+    void checkBound() const {
+#ifndef NDEBUG
+        reportIfUnbound();
+#endif
+    }
+    void reportIfUnbound() const;
+
+    /**
+     * @brief Logs load time, resolves uniforms and binds uniform blocks
+     *
+     * @param fromCache Whether the program came from the binary cache
+     */
+    void finishProgram(bool fromCache);
+
+    /**
+     * @brief Walks active uniforms of the linked program and fills the
+     * location table
+     */
+    void cacheUniformLocations();
+
+    /**
+     * @brief Binds FrameBlock and LightBlock, if the program uses them,
+     * to their fixed binding points
+     */
+    void bindUniformBlocks();
+
+    /**
+     * @brief Inserts name into the location table
+     *
+     * @param name Uniform name
+     * @param location Uniform location
+     */
+    void insertUniform(std::string_view name, int location);
+
+    int findUniform(std::string_view name, uint32_t hash) const;
+};
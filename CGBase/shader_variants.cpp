@@ -0,0 +1,64 @@
+#include "shader_variants.hpp"
+
+ShaderVariants::ShaderVariants(const std::string& vShaderPath, const std::string& fShaderPath,
+    std::function<void(const Shader&)> onCreate)
+    : mVShaderPath(vShaderPath), mFShaderPath(fShaderPath), mOnCreate(onCreate) {}
+
+void
+ShaderVariants::Prepare(const ShaderDefines& defines) {
+    findOrSubmit(defines);
+}
+
+Shader&
+ShaderVariants::Get(const ShaderDefines& defines) {
+    Variant& Found = findOrSubmit(defines);
+    if (Found.Initialized) {
+        return *Found.Program;
+    }
+
+    Found.Program->Wait();
+    Found.Initialized = true;
+    if (mOnCreate) {
+        // NOTE: May be called mid-frame, restore whatever program was bound
+        int PreviousProgram = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &PreviousProgram);
+        glUseProgram(Found.Program->GetId());
+        mOnCreate(*Found.Program);
+        glUseProgram(PreviousProgram);
+    }
+    return *Found.Program;
+}
+
+ShaderVariants::Variant&
+ShaderVariants::findOrSubmit(const ShaderDefines& defines) {
+    auto It = mVariants.find(defines.GetKey());
+    if (It != mVariants.end()) {
+        return It->second;
+    }
+
+    Variant Submitted;
+    Submitted.Program.reset(new Shader(mVShaderPath, mFShaderPath, defines, SHADER_COMPILE_ASYNC));
+    Submitted.Initialized = false;
+    return mVariants.emplace(defines.GetKey(), std::move(Submitted)).first->second;
+}
+
+void
+ShaderVariants::ReloadIfUses(const std::string& fileName) {
+    for (auto& It : mVariants) {
+        if (It.second.Program->UsesSource(fileName)) {
+            It.second.Program->Reload();
+        }
+    }
+}
+
+void
+ShaderVariants::PollReload() {
+    for (auto& It : mVariants) {
+        It.second.Program->PollReload();
+    }
+}
+
+unsigned
+ShaderVariants::GetVariantCount() const {
+    return (unsigned)mVariants.size();
+}
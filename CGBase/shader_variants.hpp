@@ -0,0 +1,73 @@
+/**
+ * @file shader_variants.hpp
+ * @brief Lazily compiled permutations of one vertex + fragment shader pair
+ *
+ */
+
+#pragma once
+#include <string>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include "shader.hpp"
+
+class ShaderVariants {
+public:
+    /**
+     * @brief Ctor - nothing is compiled until a variant is requested
+     *
+     * @param vShaderPath Vertex shader file path
+     * @param fShaderPath Fragment shader file path
+     * @param onCreate Called with the program bound after each variant is
+     * created. Use it to set uniforms that never change (samplers, etc.)
+     */
+    ShaderVariants(const std::string& vShaderPath, const std::string& fShaderPath,
+        std::function<void(const Shader&)> onCreate = nullptr);
+
+    /**
+     * @brief Submits the variant for compilation without waiting for it,
+     * so several variants (and other startup work) can overlap
+     *
+     * @param defines Permutation defines
+     */
+    void Prepare(const ShaderDefines& defines);
+
+    /**
+     * @brief Returns the variant for given defines, compiling it on first
+     * use and waiting for it if it's still being compiled
+     *
+     * @param defines Permutation defines
+     *
+     * @returns Shader variant
+     */
+    Shader& Get(const ShaderDefines& defines);
+
+    /**
+     * @brief Starts reloading every variant built from given source file
+     *
+     * @param fileName File name, without directory
+     */
+    void ReloadIfUses(const std::string& fileName);
+
+    /**
+     * @brief Swaps in every variant whose reload finished. Call at a frame boundary
+     */
+    void PollReload();
+
+    /**
+     * @brief Number of variants compiled so far
+     */
+    unsigned GetVariantCount() const;
+private:
+    std::string mVShaderPath;
+    std::string mFShaderPath;
+    std::function<void(const Shader&)> mOnCreate;
+    struct Variant {
+        std::unique_ptr<Shader> Program;
+        bool Initialized;
+    };
+
+    std::unordered_map<uint64_t, Variant> mVariants;
+
+    Variant& findOrSubmit(const ShaderDefines& defines);
+};
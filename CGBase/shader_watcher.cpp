@@ -0,0 +1,78 @@
+#include "shader_watcher.hpp"
+#include <iostream>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// NOTE: How often the watch thread checks whether it should stop
+static const int WATCH_POLL_TIMEOUT_MS = 100;
+
+ShaderWatcher::ShaderWatcher(const std::string& directory)
+    : mDirectory(directory), mFd(-1), mWatch(-1), mRunning(false) {
+#ifdef __linux__
+    mFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (mFd < 0) {
+        std::cerr << "[Warn] inotify unavailable, shader hot reload disabled" << std::endl;
+        return;
+    }
+
+    // NOTE: Editors often write a temp file and rename it over the original
+    mWatch = inotify_add_watch(mFd, mDirectory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (mWatch < 0) {
+        std::cerr << "[Warn] Failed to watch " << mDirectory << ", shader hot reload disabled" << std::endl;
+        close(mFd);
+        mFd = -1;
+        return;
+    }
+
+    mRunning = true;
+    mThread = std::thread(&ShaderWatcher::watch, this);
+#else
+    std::cout << "Shader hot reload is only supported on Linux" << std::endl;
+#endif
+}
+
+ShaderWatcher::~ShaderWatcher() {
+    mRunning = false;
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+#ifdef __linux__
+    if (mFd >= 0) {
+        close(mFd);
+    }
+#endif
+}
+
+std::vector<std::string>
+ShaderWatcher::TakeChangedFiles() {
+    std::lock_guard<std::mutex> Lock(mMutex);
+    std::vector<std::string> Changed(mChanged.begin(), mChanged.end());
+    mChanged.clear();
+    return Changed;
+}
+
+void
+ShaderWatcher::watch() {
+#ifdef __linux__
+    alignas(inotify_event) char Buffer[4096];
+    while (mRunning) {
+        pollfd Poll = { mFd, POLLIN, 0 };
+        if (poll(&Poll, 1, WATCH_POLL_TIMEOUT_MS) <= 0) {
+            continue;
+        }
+
+        ssize_t Length = read(mFd, Buffer, sizeof(Buffer));
+        for (ssize_t Offset = 0; Offset < Length;) {
+            const inotify_event* Event = (const inotify_event*)(Buffer + Offset);
+            if (Event->len) {
+                std::lock_guard<std::mutex> Lock(mMutex);
+                mChanged.insert(Event->name);
+            }
+            Offset += sizeof(inotify_event) + Event->len;
+        }
+    }
+#endif
+}
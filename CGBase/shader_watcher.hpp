@@ -0,0 +1,48 @@
+/**
+ * @file shader_watcher.hpp
+ * @brief Watches the shader directory for edits so programs can be hot reloaded
+ *
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <atomic>
+
+class ShaderWatcher {
+public:
+    /**
+     * @brief Ctor - starts watching given directory on a background thread.
+     * Only supported on Linux (inotify), elsewhere nothing is ever reported
+     *
+     * @param directory Directory containing shader sources
+     */
+    ShaderWatcher(const std::string& directory);
+    ~ShaderWatcher();
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    /**
+     * @brief Returns names of files written since the last call. Editors
+     * saving several times in a row are collapsed into one entry
+     *
+     * @returns File names, without directory
+     */
+    std::vector<std::string> TakeChangedFiles();
+private:
+    std::string mDirectory;
+    int mFd;
+    int mWatch;
+    std::atomic<bool> mRunning;
+    std::thread mThread;
+    std::mutex mMutex;
+    std::set<std::string> mChanged;
+
+    /**
+     * @brief Background loop, reads inotify events until stopped
+     */
+    void watch();
+};
@@ -1,21 +1,83 @@
 #version 330 core
 
+// NOTE: Old per-vertex inverse, only kept so the vertex benchmark can compare against it
+#ifndef PER_VERTEX_NORMAL_MATRIX
+#define PER_VERTEX_NORMAL_MATRIX 0
+#endif
+// NOTE: Diffuse map is a layer of a texture array, see texture_array.hpp
+#ifndef TEXTURE_ARRAY
+#define TEXTURE_ARRAY 0
+#endif
+// NOTE: Vertices are CompactMeshVertex, quantized positions and octahedral normals
+#ifndef COMPACT_VERTICES
+#define COMPACT_VERTICES 0
+#endif
+
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aUV;
+#if TEXTURE_ARRAY
+// NOTE: Layer of uMaterial.Kd. Per instance, or one value for the whole
+// draw when no buffer feeds it
+layout (location = 3) in float aLayer;
+#endif
+
+layout (std140) uniform FrameBlock {
+	mat4 uProjection;
+	mat4 uView;
+	vec3 uViewPos;
+};
 
-uniform mat4 uProjection;
-uniform mat4 uView;
 uniform mat4 uModel;
+// NOTE: Computed once per draw on the CPU, see GetNormalMatrix
+uniform mat3 uNormalMatrix;
+#if COMPACT_VERTICES
+// NOTE: Per mesh, positions decode as uPositionOrigin + aPos * uPositionExtent
+uniform vec3 uPositionOrigin;
+uniform vec3 uPositionExtent;
+#endif
 
 out vec2 UV;
+#if TEXTURE_ARRAY
+flat out float vLayer;
+#endif
 out vec3 vWorldSpaceFragment;
 out vec3 vWorldSpaceNormal;
 
+vec3 DecodePosition() {
+#if COMPACT_VERTICES
+	return uPositionOrigin + aPos * uPositionExtent;
+#else
+	return aPos;
+#endif
+}
+
+vec3 DecodeNormal() {
+#if COMPACT_VERTICES
+	// NOTE: Lower hemisphere is folded over the diagonals, same as DecodeOctahedral
+	vec3 Normal = vec3(aNormal.xy, 1.0f - abs(aNormal.x) - abs(aNormal.y));
+	float Fold = max(-Normal.z, 0.0f);
+	Normal.x += Normal.x >= 0.0f ? -Fold : Fold;
+	Normal.y += Normal.y >= 0.0f ? -Fold : Fold;
+	return Normal;
+#else
+	return aNormal;
+#endif
+}
+
 void main() {
-	vWorldSpaceFragment = vec3(uModel * vec4(aPos, 1.0f));
-	vWorldSpaceNormal = normalize(mat3(transpose(inverse(uModel))) * aNormal);
+	vec3 Position = DecodePosition();
+	vec3 Normal = DecodeNormal();
+	vWorldSpaceFragment = vec3(uModel * vec4(Position, 1.0f));
+#if PER_VERTEX_NORMAL_MATRIX
+	vWorldSpaceNormal = normalize(mat3(transpose(inverse(uModel))) * Normal);
+#else
+	vWorldSpaceNormal = normalize(uNormalMatrix * Normal);
+#endif
 
 	UV = aUV;
-	gl_Position = uProjection * uView * uModel * vec4(aPos, 1.0f);
+#if TEXTURE_ARRAY
+	vLayer = aLayer;
+#endif
+	gl_Position = uProjection * uView * uModel * vec4(Position, 1.0f);
 }
\ No newline at end of file
@@ -2,8 +2,12 @@
 
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 uProjection;
-uniform mat4 uView;
+layout (std140) uniform FrameBlock {
+	mat4 uProjection;
+	mat4 uView;
+	vec3 uViewPos;
+};
+
 uniform mat4 uModel;
 
 void main() {
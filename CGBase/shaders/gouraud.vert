@@ -1,92 +1,161 @@
 #version 330 core
 
+// NOTE: Permutation defines, same as phong_material_texture.frag so one
+// ShaderDefines selects matching variants of both
+#ifndef NUM_POINT_LIGHTS
+#define NUM_POINT_LIGHTS MAX_POINT_LIGHTS
+#endif
+#if NUM_POINT_LIGHTS > MAX_POINT_LIGHTS
+#error NUM_POINT_LIGHTS exceeds MAX_POINT_LIGHTS
+#endif
+#ifndef HAS_SPOTLIGHT
+#define HAS_SPOTLIGHT 1
+#endif
+#ifndef HAS_SPECULAR_MAP
+#define HAS_SPECULAR_MAP 1
+#endif
+#ifndef TEXTURE_ARRAY
+#define TEXTURE_ARRAY 0
+#endif
+// NOTE: Vertices are CompactMeshVertex, quantized positions and octahedral normals
+#ifndef COMPACT_VERTICES
+#define COMPACT_VERTICES 0
+#endif
+
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
-
-struct PositionalLight {
-	vec3 Position;
-	vec3 Ka;
-	vec3 Kd;
-	vec3 Ks;
-	float Kc;
-	float Kl;
-	float Kq;
+layout (location = 2) in vec2 aUV;
+#if TEXTURE_ARRAY
+// NOTE: Layer of uMaterial.Kd. Per instance, or one value for the whole
+// draw when no buffer feeds it
+layout (location = 3) in float aLayer;
+#endif
+
+layout (std140) uniform FrameBlock {
+	mat4 uProjection;
+	mat4 uView;
+	vec3 uViewPos;
 };
 
-struct DirectionalLight {
+// NOTE: Every vec3 is followed by a float so the struct packs tightly
+// in std140. Mirrors LightData in scene_uniforms.hpp
+struct Light {
 	vec3 Position;
+	float Kc;
 	vec3 Direction;
+	float Kl;
 	vec3 Ka;
+	float Kq;
 	vec3 Kd;
-	vec3 Ks;
 	float InnerCutOff;
+	vec3 Ks;
 	float OuterCutOff;
-	float Kc;
-	float Kl;
-	float Kq;
 };
 
-uniform PositionalLight uPointLight;
-uniform DirectionalLight uSpotlight;
-uniform DirectionalLight uDirLight;
-uniform vec3 uViewPos;
+layout (std140) uniform LightBlock {
+	Light uDirLight;
+	Light uPointLights[MAX_POINT_LIGHTS];
+	Light uSpotlight;
+	// NOTE: Squared radius past which each light adds less than 1/256,
+	// point lights in xyz, spotlight in w. Negative if it never fades out
+	vec4 uLightRadiiSq;
+};
 
-uniform mat4 uProjection;
-uniform mat4 uView;
 uniform mat4 uModel;
+// NOTE: Computed once per draw on the CPU, see GetNormalMatrix
+uniform mat3 uNormalMatrix;
+#if COMPACT_VERTICES
+// NOTE: Per mesh, positions decode as uPositionOrigin + aPos * uPositionExtent
+uniform vec3 uPositionOrigin;
+uniform vec3 uPositionExtent;
+#endif
+uniform float uShininess;
+
+out vec2 UV;
+#if TEXTURE_ARRAY
+flat out float vLayer;
+#endif
+// NOTE: Light reaching the vertex, multiplied by the material maps per fragment
+out vec3 vDiffuseLight;
+out vec3 vSpecularLight;
+
+vec3 WorldSpaceVertex;
+vec3 WorldSpaceNormal;
+vec3 ViewDirection;
+
+void AddLight(Light light, vec3 lightVector, float intensity) {
+	float Diffuse = max(dot(WorldSpaceNormal, lightVector), 0.0f);
+	vDiffuseLight += intensity * (light.Ka + Diffuse * light.Kd);
+#if HAS_SPECULAR_MAP
+	vec3 ReflectDirection = reflect(-lightVector, WorldSpaceNormal);
+	float Specular = pow(max(dot(ViewDirection, ReflectDirection), 0.0f), uShininess);
+	vSpecularLight += intensity * Specular * light.Ks;
+#endif
+}
 
-out vec3 vCol;
+float Attenuation(Light light, float distance) {
+	return 1.0f / (light.Kc + light.Kl * distance + light.Kq * (distance * distance));
+}
+
+bool InRange(vec3 toLight, float radiusSq) {
+	return radiusSq < 0.0f || dot(toLight, toLight) <= radiusSq;
+}
+
+vec3 DecodePosition() {
+#if COMPACT_VERTICES
+	return uPositionOrigin + aPos * uPositionExtent;
+#else
+	return aPos;
+#endif
+}
+
+vec3 DecodeNormal() {
+#if COMPACT_VERTICES
+	// NOTE: Lower hemisphere is folded over the diagonals, same as DecodeOctahedral
+	vec3 Normal = vec3(aNormal.xy, 1.0f - abs(aNormal.x) - abs(aNormal.y));
+	float Fold = max(-Normal.z, 0.0f);
+	Normal.x += Normal.x >= 0.0f ? -Fold : Fold;
+	Normal.y += Normal.y >= 0.0f ? -Fold : Fold;
+	return Normal;
+#else
+	return aNormal;
+#endif
+}
 
 void main() {
-	vec3 WorldSpaceVertex = vec3(uModel * vec4(aPos, 1.0f));
-	vec3 WorldSpaceNormal = normalize(mat3(transpose(inverse(uModel))) * aNormal);
-	vec3 ViewDirection = normalize(uViewPos - WorldSpaceVertex);
+	WorldSpaceVertex = vec3(uModel * vec4(DecodePosition(), 1.0f));
+	WorldSpaceNormal = normalize(uNormalMatrix * DecodeNormal());
+	ViewDirection = normalize(uViewPos - WorldSpaceVertex);
+	vDiffuseLight = vec3(0.0f);
+	vSpecularLight = vec3(0.0f);
 
 	// NOTE(Jovan): Directional light
-	vec3 DirLightVector = normalize(-uDirLight.Direction);
-	float DirDiffuse = max(dot(WorldSpaceNormal, DirLightVector), 0.0f);
-	vec3 DirReflectDirection = reflect(-DirLightVector, WorldSpaceNormal);
-	// NOTE(Jovan): 32 is the specular shininess factor. Hardcoded for now
-	float DirSpecular = pow(max(dot(ViewDirection, DirReflectDirection), 0.0f), 32.0f);
-
-	vec3 DirAmbientColor = uDirLight.Ka;
-	vec3 DirDiffuseColor = uDirLight.Kd * DirDiffuse;
-	vec3 DirSpecularColor = uDirLight.Ks * DirSpecular;
-	vec3 DirColor = DirAmbientColor + DirDiffuseColor + DirSpecularColor;
-
-	// NOTE(Jovan): Point light
-	vec3 PtLightVector = normalize(uPointLight.Position - WorldSpaceVertex);
-	float PtDiffuse = max(dot(WorldSpaceNormal, PtLightVector), 0.0f);
-	vec3 PtReflectDirection = reflect(-PtLightVector, WorldSpaceNormal);
-	float PtSpecular = pow(max(dot(ViewDirection, PtReflectDirection), 0.0f), 32.0f);
-
-	vec3 PtAmbientColor = uPointLight.Ka;
-	vec3 PtDiffuseColor = PtDiffuse * uPointLight.Kd;
-	vec3 PtSpecularColor = PtSpecular * uPointLight.Ks;
-
-	float PtLightDistance = length(uPointLight.Position - WorldSpaceVertex);
-	float PtAttenuation = 1.0f / (uPointLight.Kc + uPointLight.Kl * PtLightDistance + uPointLight.Kq * (PtLightDistance * PtLightDistance));
-	vec3 PtColor = PtAttenuation * (PtAmbientColor + PtDiffuseColor + PtSpecularColor);
-
-	// NOTE(Jovan): Spotlight
-	vec3 SpotlightVector = normalize(uSpotlight.Position - WorldSpaceVertex);
-
-	float SpotDiffuse = max(dot(WorldSpaceNormal, SpotlightVector), 0.0f);
-	vec3 SpotReflectDirection = reflect(-SpotlightVector, WorldSpaceNormal);
-	float SpotSpecular = pow(max(dot(ViewDirection, SpotReflectDirection), 0.0f), 32.0f);
-
-	vec3 SpotAmbientColor = uSpotlight.Ka;
-	vec3 SpotDiffuseColor = SpotDiffuse * uSpotlight.Kd;
-	vec3 SpotSpecularColor = SpotSpecular * uSpotlight.Ks;
-
-	float SpotlightDistance = length(uSpotlight.Position - WorldSpaceVertex);
-	float SpotAttenuation = 1.0f / (uSpotlight.Kc + uSpotlight.Kl * SpotlightDistance + uSpotlight.Kq * (SpotlightDistance * SpotlightDistance));
-
-	float Theta = dot(SpotlightVector, normalize(-uSpotlight.Direction));
-	float Epsilon = uSpotlight.InnerCutOff - uSpotlight.OuterCutOff;
-	float SpotIntensity = clamp((Theta - uSpotlight.OuterCutOff) / Epsilon, 0.0f, 1.0f);
-	vec3 SpotColor = SpotIntensity * SpotAttenuation * (SpotAmbientColor + SpotDiffuseColor + SpotSpecularColor);
-
-	vCol = DirColor + PtColor + SpotColor;
-	gl_Position = uProjection * uView * uModel * vec4(aPos, 1.0f);
+	AddLight(uDirLight, normalize(-uDirLight.Direction), 1.0f);
+
+	for (int LightIdx = 0; LightIdx < NUM_POINT_LIGHTS; ++LightIdx) {
+		vec3 ToLight = uPointLights[LightIdx].Position - WorldSpaceVertex;
+		if (!InRange(ToLight, uLightRadiiSq[LightIdx])) {
+			continue;
+		}
+		float Distance = length(ToLight);
+		AddLight(uPointLights[LightIdx], ToLight / Distance, Attenuation(uPointLights[LightIdx], Distance));
+	}
+
+#if HAS_SPOTLIGHT
+	vec3 ToSpotlight = uSpotlight.Position - WorldSpaceVertex;
+	if (InRange(ToSpotlight, uLightRadiiSq.w)) {
+		float Distance = length(ToSpotlight);
+		vec3 SpotlightVector = ToSpotlight / Distance;
+		float Theta = dot(SpotlightVector, normalize(-uSpotlight.Direction));
+		float Epsilon = uSpotlight.InnerCutOff - uSpotlight.OuterCutOff;
+		float SpotIntensity = clamp((Theta - uSpotlight.OuterCutOff) / Epsilon, 0.0f, 1.0f);
+		AddLight(uSpotlight, SpotlightVector, SpotIntensity * Attenuation(uSpotlight, Distance));
+	}
+#endif
+
+	UV = aUV;
+#if TEXTURE_ARRAY
+	vLayer = aLayer;
+#endif
+	gl_Position = uProjection * uView * vec4(WorldSpaceVertex, 1.0f);
 }
@@ -0,0 +1,40 @@
+#version 330 core
+
+#ifndef HAS_SPECULAR_MAP
+#define HAS_SPECULAR_MAP 1
+#endif
+#ifndef TEXTURE_ARRAY
+#define TEXTURE_ARRAY 0
+#endif
+
+struct Material {
+#if TEXTURE_ARRAY
+	sampler2DArray Kd;
+#else
+	sampler2D Kd;
+#endif
+	sampler2D Ks;
+	float Shininess;
+};
+
+uniform Material uMaterial;
+
+in vec2 UV;
+#if TEXTURE_ARRAY
+flat in float vLayer;
+#define KD_UV vec3(UV, vLayer)
+#else
+#define KD_UV UV
+#endif
+in vec3 vDiffuseLight;
+in vec3 vSpecularLight;
+
+out vec4 FragColor;
+
+void main() {
+	vec3 FinalColor = vDiffuseLight * vec3(texture(uMaterial.Kd, KD_UV));
+#if HAS_SPECULAR_MAP
+	FinalColor += vSpecularLight * vec3(texture(uMaterial.Ks, UV));
+#endif
+	FragColor = vec4(FinalColor, 1.0f);
+}
@@ -1,122 +1,133 @@
 #version 330 core
 
-struct PositionalLight {
+// NOTE: Permutation defines, injected by Shader after #version.
+// Defaults reproduce the full lighting model. MAX_POINT_LIGHTS is always
+// injected, it sizes LightBlock the same as scene_uniforms.hpp
+#ifndef NUM_POINT_LIGHTS
+#define NUM_POINT_LIGHTS MAX_POINT_LIGHTS
+#endif
+#if NUM_POINT_LIGHTS > MAX_POINT_LIGHTS
+#error NUM_POINT_LIGHTS exceeds MAX_POINT_LIGHTS
+#endif
+#ifndef HAS_SPOTLIGHT
+#define HAS_SPOTLIGHT 1
+#endif
+#ifndef HAS_SPECULAR_MAP
+#define HAS_SPECULAR_MAP 1
+#endif
+#ifndef TEXTURE_ARRAY
+#define TEXTURE_ARRAY 0
+#endif
+
+// NOTE: Every vec3 is followed by a float so the struct packs tightly
+// in std140. Mirrors LightData in scene_uniforms.hpp
+struct Light {
 	vec3 Position;
-	vec3 Ka;
-	vec3 Kd;
-	vec3 Ks;
 	float Kc;
-	float Kl;
-	float Kq;
-};
-
-struct DirectionalLight {
-	vec3 Position;
 	vec3 Direction;
+	float Kl;
 	vec3 Ka;
+	float Kq;
 	vec3 Kd;
-	vec3 Ks;
 	float InnerCutOff;
+	vec3 Ks;
 	float OuterCutOff;
-	float Kc;
-	float Kl;
-	float Kq;
+};
+
+layout (std140) uniform LightBlock {
+	Light uDirLight;
+	Light uPointLights[MAX_POINT_LIGHTS];
+	Light uSpotlight;
+	// NOTE: Squared radius past which each light adds less than 1/256,
+	// point lights in xyz, spotlight in w. Negative if it never fades out
+	vec4 uLightRadiiSq;
 };
 
 struct Material {
+#if TEXTURE_ARRAY
+	sampler2DArray Kd;
+#else
 	sampler2D Kd;
+#endif
 	sampler2D Ks;
 	float Shininess;
 };
 
-uniform PositionalLight uPointLight;
-uniform PositionalLight uPointLightSecond;
-uniform PositionalLight uPointLightThird;
-uniform DirectionalLight uSpotlight;
-uniform DirectionalLight uDirLight;
+layout (std140) uniform FrameBlock {
+	mat4 uProjection;
+	mat4 uView;
+	vec3 uViewPos;
+};
+
 uniform Material uMaterial;
-uniform vec3 uViewPos;
 
 in vec2 UV;
+#if TEXTURE_ARRAY
+flat in float vLayer;
+#define KD_UV vec3(UV, vLayer)
+#else
+#define KD_UV UV
+#endif
 in vec3 vWorldSpaceFragment;
 in vec3 vWorldSpaceNormal;
 
 out vec4 FragColor;
 
-void main() {
-	vec3 ViewDirection = normalize(uViewPos - vWorldSpaceFragment);
-	// NOTE(Jovan): Directional light
-	vec3 DirLightVector = normalize(-uDirLight.Direction);
-	float DirDiffuse = max(dot(vWorldSpaceNormal, DirLightVector), 0.0f);
-	vec3 DirReflectDirection = reflect(-DirLightVector, vWorldSpaceNormal);
-	float DirSpecular = pow(max(dot(ViewDirection, DirReflectDirection), 0.0f), uMaterial.Shininess);
-
-	vec3 DirAmbientColor = uDirLight.Ka * vec3(texture(uMaterial.Kd, UV));
-	vec3 DirDiffuseColor = uDirLight.Kd * DirDiffuse * vec3(texture(uMaterial.Kd, UV));
-	vec3 DirSpecularColor = uDirLight.Ks * DirSpecular * vec3(texture(uMaterial.Ks, UV));
-	vec3 DirColor = DirAmbientColor + DirDiffuseColor + DirSpecularColor;
-
-	// Point light
-	vec3 PtLightVector = normalize(uPointLight.Position - vWorldSpaceFragment);
-	float PtDiffuse = max(dot(vWorldSpaceNormal, PtLightVector), 0.0f);
-	vec3 PtReflectDirection = reflect(-PtLightVector, vWorldSpaceNormal);
-	float PtSpecular = pow(max(dot(ViewDirection, PtReflectDirection), 0.0f), uMaterial.Shininess);
-
-	vec3 PtAmbientColor = uPointLight.Ka * vec3(texture(uMaterial.Kd, UV));
-	vec3 PtDiffuseColor = PtDiffuse * uPointLight.Kd * vec3(texture(uMaterial.Kd, UV));
-	vec3 PtSpecularColor = PtSpecular * uPointLight.Ks * vec3(texture(uMaterial.Ks, UV));
-
-	float PtLightDistance = length(uPointLight.Position - vWorldSpaceFragment);
-	float PtAttenuation = 1.0f / (uPointLight.Kc + uPointLight.Kl * PtLightDistance + uPointLight.Kq * (PtLightDistance * PtLightDistance));
-	vec3 PtColor = PtAttenuation * (PtAmbientColor + PtDiffuseColor + PtSpecularColor);
-
-	// Point light second
-	PtLightVector = normalize(uPointLightSecond.Position - vWorldSpaceFragment);
-	PtDiffuse = max(dot(vWorldSpaceNormal, PtLightVector), 0.0f);
-	PtReflectDirection = reflect(-PtLightVector, vWorldSpaceNormal);
-	PtSpecular = pow(max(dot(ViewDirection, PtReflectDirection), 0.0f), uMaterial.Shininess);
-
-	PtAmbientColor = uPointLightSecond.Ka * vec3(texture(uMaterial.Kd, UV));
-	PtDiffuseColor = PtDiffuse * uPointLightSecond.Kd * vec3(texture(uMaterial.Kd, UV));
-	PtSpecularColor = PtSpecular * uPointLightSecond.Ks * vec3(texture(uMaterial.Ks, UV));
-
-	PtLightDistance = length(uPointLightSecond.Position - vWorldSpaceFragment);
-	PtAttenuation = 1.0f / (uPointLightSecond.Kc + uPointLightSecond.Kl * PtLightDistance + uPointLightSecond.Kq * (PtLightDistance * PtLightDistance));
-	PtColor += PtAttenuation * (PtAmbientColor + PtDiffuseColor + PtSpecularColor);
-
-	// Point light third
-	PtLightVector = normalize(uPointLightThird.Position - vWorldSpaceFragment);
-	PtDiffuse = max(dot(vWorldSpaceNormal, PtLightVector), 0.0f);
-	PtReflectDirection = reflect(-PtLightVector, vWorldSpaceNormal);
-	PtSpecular = pow(max(dot(ViewDirection, PtReflectDirection), 0.0f), uMaterial.Shininess);
-
-	PtAmbientColor = uPointLightThird.Ka * vec3(texture(uMaterial.Kd, UV));
-	PtDiffuseColor = PtDiffuse * uPointLightThird.Kd * vec3(texture(uMaterial.Kd, UV));
-	PtSpecularColor = PtSpecular * uPointLightThird.Ks * vec3(texture(uMaterial.Ks, UV));
-
-	PtLightDistance = length(uPointLightThird.Position - vWorldSpaceFragment);
-	PtAttenuation = 1.0f / (uPointLightThird.Kc + uPointLightThird.Kl * PtLightDistance + uPointLightThird.Kq * (PtLightDistance * PtLightDistance));
-	PtColor += PtAttenuation * (PtAmbientColor + PtDiffuseColor + PtSpecularColor);
-
-	// Spotlight
-	vec3 SpotlightVector = normalize(uSpotlight.Position - vWorldSpaceFragment);
+// NOTE: Ambient + diffuse + specular of a light shining along LightVector, unattenuated.
+// Material maps are sampled once in main and passed in
+vec3 ShadeLight(Light light, vec3 lightVector, vec3 viewDirection, vec3 albedo, vec3 specularAlbedo) {
+	float Diffuse = max(dot(vWorldSpaceNormal, lightVector), 0.0f);
+	vec3 Color = (light.Ka + Diffuse * light.Kd) * albedo;
+#if HAS_SPECULAR_MAP
+	vec3 ReflectDirection = reflect(-lightVector, vWorldSpaceNormal);
+	float Specular = pow(max(dot(viewDirection, ReflectDirection), 0.0f), uMaterial.Shininess);
+	Color += Specular * light.Ks * specularAlbedo;
+#endif
+	return Color;
+}
 
-	float SpotDiffuse = max(dot(vWorldSpaceNormal, SpotlightVector), 0.0f);
-	vec3 SpotReflectDirection = reflect(-SpotlightVector, vWorldSpaceNormal);
-	float SpotSpecular = pow(max(dot(ViewDirection, SpotReflectDirection), 0.0f), uMaterial.Shininess);
+float Attenuation(Light light, float distance) {
+	return 1.0f / (light.Kc + light.Kl * distance + light.Kq * (distance * distance));
+}
 
-	vec3 SpotAmbientColor = uSpotlight.Ka * vec3(texture(uMaterial.Kd, UV));
-	vec3 SpotDiffuseColor = SpotDiffuse * uSpotlight.Kd * vec3(texture(uMaterial.Kd, UV));
-	vec3 SpotSpecularColor = SpotSpecular * uSpotlight.Ks * vec3(texture(uMaterial.Ks, UV));
+// NOTE: Lights past their radius would add less than one 8-bit step, skip them
+bool InRange(vec3 toLight, float radiusSq) {
+	return radiusSq < 0.0f || dot(toLight, toLight) <= radiusSq;
+}
 
-	float SpotlightDistance = length(uSpotlight.Position - vWorldSpaceFragment);
-	float SpotAttenuation = 1.0f / (uSpotlight.Kc + uSpotlight.Kl * SpotlightDistance + uSpotlight.Kq * (SpotlightDistance * SpotlightDistance));
+void main() {
+	vec3 Albedo = vec3(texture(uMaterial.Kd, KD_UV));
+#if HAS_SPECULAR_MAP
+	vec3 SpecularAlbedo = vec3(texture(uMaterial.Ks, UV));
+#else
+	vec3 SpecularAlbedo = vec3(0.0f);
+#endif
+	vec3 ViewDirection = normalize(uViewPos - vWorldSpaceFragment);
+	// NOTE(Jovan): Directional light
+	vec3 FinalColor = ShadeLight(uDirLight, normalize(-uDirLight.Direction), ViewDirection, Albedo, SpecularAlbedo);
+
+	for (int LightIdx = 0; LightIdx < NUM_POINT_LIGHTS; ++LightIdx) {
+		vec3 ToLight = uPointLights[LightIdx].Position - vWorldSpaceFragment;
+		if (!InRange(ToLight, uLightRadiiSq[LightIdx])) {
+			continue;
+		}
+		float Distance = length(ToLight);
+		FinalColor += Attenuation(uPointLights[LightIdx], Distance)
+			* ShadeLight(uPointLights[LightIdx], ToLight / Distance, ViewDirection, Albedo, SpecularAlbedo);
+	}
+
+#if HAS_SPOTLIGHT
+	vec3 ToSpotlight = uSpotlight.Position - vWorldSpaceFragment;
+	if (InRange(ToSpotlight, uLightRadiiSq.w)) {
+		float Distance = length(ToSpotlight);
+		vec3 SpotlightVector = ToSpotlight / Distance;
+		float Theta = dot(SpotlightVector, normalize(-uSpotlight.Direction));
+		float Epsilon = uSpotlight.InnerCutOff - uSpotlight.OuterCutOff;
+		float SpotIntensity = clamp((Theta - uSpotlight.OuterCutOff) / Epsilon, 0.0f, 1.0f);
+		FinalColor += SpotIntensity * Attenuation(uSpotlight, Distance)
+			* ShadeLight(uSpotlight, SpotlightVector, ViewDirection, Albedo, SpecularAlbedo);
+	}
+#endif
 
-	float Theta = dot(SpotlightVector, normalize(-uSpotlight.Direction));
-	float Epsilon = uSpotlight.InnerCutOff - uSpotlight.OuterCutOff;
-	float SpotIntensity = clamp((Theta - uSpotlight.OuterCutOff) / Epsilon, 0.0f, 1.0f);
-	vec3 SpotColor = SpotIntensity * SpotAttenuation * (SpotAmbientColor + SpotDiffuseColor + SpotSpecularColor);
-	
-	vec3 FinalColor = DirColor + PtColor + SpotColor;
 	FragColor = vec4(FinalColor, 1.0f);
 }
@@ -0,0 +1,143 @@
+#version 330 core
+
+// NOTE: Baseline lighting kernel, kept as the reference for the golden
+// image comparison (--golden). Not used for rendering. Only the inputs
+// changed since: lights and camera come from uniform blocks and the
+// diffuse map may be a texture array layer. Every light is always shaded
+// and the specular map is always sampled, whatever the permutation
+// defines say. An unbound uMaterial.Ks samples black
+
+// NOTE: Only changes where the diffuse map is sampled from, so the same
+// objects can be drawn with both kernels
+#ifndef TEXTURE_ARRAY
+#define TEXTURE_ARRAY 0
+#endif
+
+// NOTE: Mirrors LightData in scene_uniforms.hpp
+struct Light {
+	vec3 Position;
+	float Kc;
+	vec3 Direction;
+	float Kl;
+	vec3 Ka;
+	float Kq;
+	vec3 Kd;
+	float InnerCutOff;
+	vec3 Ks;
+	float OuterCutOff;
+};
+
+layout (std140) uniform LightBlock {
+	Light uDirLight;
+	Light uPointLights[MAX_POINT_LIGHTS];
+	Light uSpotlight;
+	vec4 uLightRadiiSq;
+};
+
+struct Material {
+#if TEXTURE_ARRAY
+	sampler2DArray Kd;
+#else
+	sampler2D Kd;
+#endif
+	sampler2D Ks;
+	float Shininess;
+};
+
+layout (std140) uniform FrameBlock {
+	mat4 uProjection;
+	mat4 uView;
+	vec3 uViewPos;
+};
+
+uniform Material uMaterial;
+
+in vec2 UV;
+#if TEXTURE_ARRAY
+flat in float vLayer;
+#define KD_UV vec3(UV, vLayer)
+#else
+#define KD_UV UV
+#endif
+in vec3 vWorldSpaceFragment;
+in vec3 vWorldSpaceNormal;
+
+out vec4 FragColor;
+
+void main() {
+	vec3 ViewDirection = normalize(uViewPos - vWorldSpaceFragment);
+	// NOTE(Jovan): Directional light
+	vec3 DirLightVector = normalize(-uDirLight.Direction);
+	float DirDiffuse = max(dot(vWorldSpaceNormal, DirLightVector), 0.0f);
+	vec3 DirReflectDirection = reflect(-DirLightVector, vWorldSpaceNormal);
+	float DirSpecular = pow(max(dot(ViewDirection, DirReflectDirection), 0.0f), uMaterial.Shininess);
+
+	vec3 DirAmbientColor = uDirLight.Ka * vec3(texture(uMaterial.Kd, KD_UV));
+	vec3 DirDiffuseColor = uDirLight.Kd * DirDiffuse * vec3(texture(uMaterial.Kd, KD_UV));
+	vec3 DirSpecularColor = uDirLight.Ks * DirSpecular * vec3(texture(uMaterial.Ks, UV));
+	vec3 DirColor = DirAmbientColor + DirDiffuseColor + DirSpecularColor;
+
+	// Point light
+	vec3 PtLightVector = normalize(uPointLights[0].Position - vWorldSpaceFragment);
+	float PtDiffuse = max(dot(vWorldSpaceNormal, PtLightVector), 0.0f);
+	vec3 PtReflectDirection = reflect(-PtLightVector, vWorldSpaceNormal);
+	float PtSpecular = pow(max(dot(ViewDirection, PtReflectDirection), 0.0f), uMaterial.Shininess);
+
+	vec3 PtAmbientColor = uPointLights[0].Ka * vec3(texture(uMaterial.Kd, KD_UV));
+	vec3 PtDiffuseColor = PtDiffuse * uPointLights[0].Kd * vec3(texture(uMaterial.Kd, KD_UV));
+	vec3 PtSpecularColor = PtSpecular * uPointLights[0].Ks * vec3(texture(uMaterial.Ks, UV));
+
+	float PtLightDistance = length(uPointLights[0].Position - vWorldSpaceFragment);
+	float PtAttenuation = 1.0f / (uPointLights[0].Kc + uPointLights[0].Kl * PtLightDistance + uPointLights[0].Kq * (PtLightDistance * PtLightDistance));
+	vec3 PtColor = PtAttenuation * (PtAmbientColor + PtDiffuseColor + PtSpecularColor);
+
+	// Point light second
+	PtLightVector = normalize(uPointLights[1].Position - vWorldSpaceFragment);
+	PtDiffuse = max(dot(vWorldSpaceNormal, PtLightVector), 0.0f);
+	PtReflectDirection = reflect(-PtLightVector, vWorldSpaceNormal);
+	PtSpecular = pow(max(dot(ViewDirection, PtReflectDirection), 0.0f), uMaterial.Shininess);
+
+	PtAmbientColor = uPointLights[1].Ka * vec3(texture(uMaterial.Kd, KD_UV));
+	PtDiffuseColor = PtDiffuse * uPointLights[1].Kd * vec3(texture(uMaterial.Kd, KD_UV));
+	PtSpecularColor = PtSpecular * uPointLights[1].Ks * vec3(texture(uMaterial.Ks, UV));
+
+	PtLightDistance = length(uPointLights[1].Position - vWorldSpaceFragment);
+	PtAttenuation = 1.0f / (uPointLights[1].Kc + uPointLights[1].Kl * PtLightDistance + uPointLights[1].Kq * (PtLightDistance * PtLightDistance));
+	PtColor += PtAttenuation * (PtAmbientColor + PtDiffuseColor + PtSpecularColor);
+
+	// Point light third
+	PtLightVector = normalize(uPointLights[2].Position - vWorldSpaceFragment);
+	PtDiffuse = max(dot(vWorldSpaceNormal, PtLightVector), 0.0f);
+	PtReflectDirection = reflect(-PtLightVector, vWorldSpaceNormal);
+	PtSpecular = pow(max(dot(ViewDirection, PtReflectDirection), 0.0f), uMaterial.Shininess);
+
+	PtAmbientColor = uPointLights[2].Ka * vec3(texture(uMaterial.Kd, KD_UV));
+	PtDiffuseColor = PtDiffuse * uPointLights[2].Kd * vec3(texture(uMaterial.Kd, KD_UV));
+	PtSpecularColor = PtSpecular * uPointLights[2].Ks * vec3(texture(uMaterial.Ks, UV));
+
+	PtLightDistance = length(uPointLights[2].Position - vWorldSpaceFragment);
+	PtAttenuation = 1.0f / (uPointLights[2].Kc + uPointLights[2].Kl * PtLightDistance + uPointLights[2].Kq * (PtLightDistance * PtLightDistance));
+	PtColor += PtAttenuation * (PtAmbientColor + PtDiffuseColor + PtSpecularColor);
+
+	// Spotlight
+	vec3 SpotlightVector = normalize(uSpotlight.Position - vWorldSpaceFragment);
+
+	float SpotDiffuse = max(dot(vWorldSpaceNormal, SpotlightVector), 0.0f);
+	vec3 SpotReflectDirection = reflect(-SpotlightVector, vWorldSpaceNormal);
+	float SpotSpecular = pow(max(dot(ViewDirection, SpotReflectDirection), 0.0f), uMaterial.Shininess);
+
+	vec3 SpotAmbientColor = uSpotlight.Ka * vec3(texture(uMaterial.Kd, KD_UV));
+	vec3 SpotDiffuseColor = SpotDiffuse * uSpotlight.Kd * vec3(texture(uMaterial.Kd, KD_UV));
+	vec3 SpotSpecularColor = SpotSpecular * uSpotlight.Ks * vec3(texture(uMaterial.Ks, UV));
+
+	float SpotlightDistance = length(uSpotlight.Position - vWorldSpaceFragment);
+	float SpotAttenuation = 1.0f / (uSpotlight.Kc + uSpotlight.Kl * SpotlightDistance + uSpotlight.Kq * (SpotlightDistance * SpotlightDistance));
+
+	float Theta = dot(SpotlightVector, normalize(-uSpotlight.Direction));
+	float Epsilon = uSpotlight.InnerCutOff - uSpotlight.OuterCutOff;
+	float SpotIntensity = clamp((Theta - uSpotlight.OuterCutOff) / Epsilon, 0.0f, 1.0f);
+	vec3 SpotColor = SpotIntensity * SpotAttenuation * (SpotAmbientColor + SpotDiffuseColor + SpotSpecularColor);
+	
+	vec3 FinalColor = DirColor + PtColor + SpotColor;
+	FragColor = vec4(FinalColor, 1.0f);
+}
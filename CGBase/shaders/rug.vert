@@ -4,8 +4,12 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aCol;
 out vec3 chCol;
 
-uniform mat4 uProjection;
-uniform mat4 uView;
+layout (std140) uniform FrameBlock {
+	mat4 uProjection;
+	mat4 uView;
+	vec3 uViewPos;
+};
+
 uniform mat4 uModel;
 uniform vec3 offset;
 
@@ -1,6 +1,15 @@
 #include "texture.hpp"
-#define STB_IMAGE_IMPLEMENTATION
+#include "texture_decoder.hpp"
+#include "mapped_file.hpp"
 #include "stb_image.h"
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTURE_SSE2 1
+#include <emmintrin.h>
+#endif
 
 unsigned
 Texture::LoadImageToTexture(const std::string& filePath) {
@@ -8,28 +17,132 @@ Texture::LoadImageToTexture(const std::string& filePath) {
     int TextureHeight;
     int TextureChannels;
     std::cout << "Loading texture: " << filePath << std::endl;
-    unsigned char* ImageData = stbi_load(filePath.c_str(), &TextureWidth, &TextureHeight, &TextureChannels, 0);
+    unsigned char* ImageData = DecodeImage(filePath, &TextureWidth, &TextureHeight, &TextureChannels);
 
     if (!ImageData) {
         std::cerr << "Failed to load texture: " << filePath << " loading default instead" << std::endl;
         return LoadImageToTexture(MISSING_TEXTURE_PATH);
     }
 
-    //Loaded upside-down => flip!
-    stbi__vertical_flip(ImageData, TextureWidth, TextureHeight, TextureChannels);
+    unsigned Texture;
+    glGenTextures(1, &Texture);
+    UploadImage(Texture, ImageData, TextureWidth, TextureHeight, TextureChannels);
+    FreeImage(ImageData);
+    return Texture;
+}
+
+unsigned char*
+Texture::DecodeImage(const std::string& filePath, int* width, int* height, int* channels, TextureQuality quality) {
+    MappedFile Encoded;
+    if (!Encoded.Open(filePath)) {
+        return 0;
+    }
+    return DecodeImageFromMemory(Encoded.GetData(), Encoded.GetSize(), width, height, channels, quality);
+}
+
+unsigned char*
+Texture::DecodeImageFromMemory(const unsigned char* data, size_t size, int* width, int* height, int* channels, TextureQuality quality) {
+    // NOTE: A backend that claims the data can still reject it, CMYK JPEGs
+    // for libjpeg-turbo, the next one gets a try then
+    for (const ImageDecoder* Decoder : GetImageDecoders()) {
+        if (!Decoder->CanDecode(data, size)) {
+            continue;
+        }
+
+        unsigned char* Pixels = Decoder->Decode(data, size, width, height, channels, quality);
+        if (Pixels) {
+            return Pixels;
+        }
+    }
+    return 0;
+}
 
+void
+Texture::DownsampleFlipped(const unsigned char* pixels, int width, int height, int channels, unsigned factorLog2, unsigned char* out) {
+    const int Factor = 1 << factorLog2;
+    const int OutWidth = (width + Factor - 1) >> factorLog2;
+    const int OutHeight = (height + Factor - 1) >> factorLog2;
+    const size_t SrcStride = (size_t)width * channels;
+    const int SumCount = width * channels;
+    const unsigned Shift = 2 * factorLog2;
+    const unsigned Round = 1u << (Shift - 1);
+    std::vector<uint16_t> ColumnSums(SumCount);
+
+    for (int OutY = 0; OutY < OutHeight; ++OutY) {
+        // NOTE: Output rows are bottom-up, so the flip is just which source rows are read
+        const unsigned char* Box = pixels + (size_t)OutY * Factor * SrcStride;
+        unsigned char* OutRow = out + (size_t)(OutHeight - 1 - OutY) * OutWidth * channels;
+        // NOTE: The last row and column of boxes can be partial, those average what they cover
+        const int Rows = std::min(Factor, height - OutY * Factor);
+
+        // NOTE: Vertical pass sums the box's rows per byte, the channel layout doesn't matter here
+        int SumIdx = 0;
+#ifdef TEXTURE_SSE2
+        const __m128i Zero = _mm_setzero_si128();
+        for (; SumIdx + 16 <= SumCount; SumIdx += 16) {
+            __m128i Low = Zero;
+            __m128i High = Zero;
+            for (int Row = 0; Row < Rows; ++Row) {
+                __m128i Bytes = _mm_loadu_si128((const __m128i*)(Box + Row * SrcStride + SumIdx));
+                Low = _mm_add_epi16(Low, _mm_unpacklo_epi8(Bytes, Zero));
+                High = _mm_add_epi16(High, _mm_unpackhi_epi8(Bytes, Zero));
+            }
+            _mm_storeu_si128((__m128i*)(ColumnSums.data() + SumIdx), Low);
+            _mm_storeu_si128((__m128i*)(ColumnSums.data() + SumIdx + 8), High);
+        }
+#endif
+        for (; SumIdx < SumCount; ++SumIdx) {
+            unsigned Sum = 0;
+            for (int Row = 0; Row < Rows; ++Row) {
+                Sum += Box[Row * SrcStride + SumIdx];
+            }
+            ColumnSums[SumIdx] = (uint16_t)Sum;
+        }
+
+        // NOTE: Horizontal pass works on the already halved or quartered data
+        const uint16_t* Sums = ColumnSums.data();
+        for (int OutX = 0; OutX < OutWidth; ++OutX) {
+            const int Columns = std::min(Factor, width - OutX * Factor);
+            const unsigned Count = (unsigned)(Rows * Columns);
+            for (int Channel = 0; Channel < channels; ++Channel) {
+                unsigned Sum = 0;
+                for (int Column = 0; Column < Columns; ++Column) {
+                    Sum += Sums[Column * channels + Channel];
+                }
+                *OutRow++ = (unsigned char)(Count == 1u << Shift ? (Sum + Round) >> Shift : (Sum + Count / 2) / Count);
+            }
+            Sums += Factor * channels;
+        }
+    }
+}
+
+void
+Texture::FreeImage(unsigned char* pixels) {
+    stbi_image_free(pixels);
+}
+
+void
+Texture::UploadImage(unsigned texture, const unsigned char* pixels, int width, int height, int channels, unsigned pixelBuffer) {
     GLint InternalFormat = -1;
-    switch (TextureChannels) {
+    switch (channels) {
     case 1: InternalFormat = GL_RED; break;
     case 3: InternalFormat = GL_RGB; break;
     case 4: InternalFormat = GL_RGBA; break;
     default: InternalFormat = GL_RGB; break;
     }
 
-    unsigned Texture;
-    glGenTextures(1, &Texture);
-    glBindTexture(GL_TEXTURE_2D, Texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, InternalFormat, TextureWidth, TextureHeight, 0, InternalFormat, GL_UNSIGNED_BYTE, ImageData);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    // NOTE: Storage is allocated before the unpack buffer is bound, otherwise
+    // this would read from it too
+    glTexImage2D(GL_TEXTURE_2D, 0, InternalFormat, width, height, 0, InternalFormat, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+    // NOTE: RGB rows of odd widths aren't 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, InternalFormat, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    // NOTE: A placeholder may have limited the chain to one level
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
     glGenerateMipmap(GL_TEXTURE_2D);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
@@ -37,6 +150,60 @@ Texture::LoadImageToTexture(const std::string& filePath) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glBindTexture(GL_TEXTURE_2D, 0);
-    stbi_image_free(ImageData);
-    return Texture;
-}
\ No newline at end of file
+}
+
+// NOTE: Zero sized images free the memory of levels a shorter chain no longer uses
+static void
+releaseLevels(unsigned firstLevel) {
+    for (unsigned Level = firstLevel; Level < COOKED_TEXTURE_MAX_MIPS; ++Level) {
+        glTexImage2D(GL_TEXTURE_2D, Level, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    }
+}
+
+void
+Texture::UploadCookedMips(unsigned texture, const CookedTexture& cooked, unsigned firstMip, unsigned lastMip, const unsigned char* mips, unsigned pixelBuffer) {
+    uint32_t First = cooked.Mips[firstMip].Offset;
+    glBindTexture(GL_TEXTURE_2D, texture);
+    // NOTE: Storage is allocated before the unpack buffer is bound, otherwise
+    // this would read from it too. Levels outside the range are left alone
+    for (unsigned MipIdx = firstMip; MipIdx <= lastMip; ++MipIdx) {
+        const CookedTextureMip& Mip = cooked.Mips[MipIdx];
+        glCompressedTexImage2D(GL_TEXTURE_2D, MipIdx, cooked.Header->Format, Mip.Width, Mip.Height, 0, Mip.Size, 0);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+    for (unsigned MipIdx = firstMip; MipIdx <= lastMip; ++MipIdx) {
+        const CookedTextureMip& Mip = cooked.Mips[MipIdx];
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, MipIdx, 0, 0, Mip.Width, Mip.Height, cooked.Header->Format, Mip.Size, mips + (Mip.Offset - First));
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    // NOTE: Sampling never reaches levels finer than the base, which aren't uploaded.
+    // The chain may stop short of 1x1 (COOKED_TEXTURE_MAX_MIPS), keep it complete
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, firstMip);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, cooked.Header->MipCount - 1);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void
+Texture::ReleaseMip(unsigned texture, unsigned mip) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, mip + 1);
+    glTexImage2D(GL_TEXTURE_2D, mip, GL_RGBA, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void
+Texture::UploadPlaceholder(unsigned texture, const unsigned char* pixel) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+    releaseLevels(1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -2,9 +2,17 @@
 #include <string>
 #include <GL/glew.h>
 #include <iostream>
+#include "cooked_texture.hpp"
 
 static const std::string MISSING_TEXTURE_PATH = "res/missing_texture";
 
+// NOTE: Value is the number of times images are halved when loaded
+enum TextureQuality {
+	TEXTURE_QUALITY_FULL = 0,
+	TEXTURE_QUALITY_HALF = 1,
+	TEXTURE_QUALITY_QUARTER = 2,
+};
+
 class Texture {
 public:
 	/**
@@ -17,4 +25,102 @@ public:
 	 * @returns TextureID
 	 */
 	static unsigned LoadImageToTexture(const std::string& filePath);
+
+	/**
+	 * @brief Decodes image file into GL's bottom-up row order with the
+	 * preferred backend for its format, see texture_decoder.hpp.
+	 * Touches no GL state, safe to call from any thread
+	 *
+	 * @param filePath Image file path
+	 * @param width Output width
+	 * @param height Output height
+	 * @param channels Output channel count
+	 * @param quality Box filters the image down by this tier in the same pass as the flip
+	 * @returns Pixels, free with FreeImage. nullptr on failure
+	 */
+	static unsigned char* DecodeImage(const std::string& filePath, int* width, int* height, int* channels, TextureQuality quality = TEXTURE_QUALITY_FULL);
+
+	/**
+	 * @brief DecodeImage for an encoded file already in memory
+	 *
+	 * @param data Encoded file contents
+	 * @param size Size in bytes
+	 * @param width Output width
+	 * @param height Output height
+	 * @param channels Output channel count
+	 * @param quality Box filters the image down by this tier in the same pass as the flip
+	 * @returns Pixels from the first backend that claims and decodes the data,
+	 * free with FreeImage. nullptr when none does
+	 */
+	static unsigned char* DecodeImageFromMemory(const unsigned char* data, size_t size, int* width, int* height, int* channels, TextureQuality quality = TEXTURE_QUALITY_FULL);
+
+	/**
+	 * @brief Box filters top-down pixels by 2^factorLog2 in both directions
+	 * and flips them to bottom-up rows, reading every source pixel once.
+	 * Sizes round up like libjpeg-turbo's scaled IDCT, leftover rows and
+	 * columns become partial boxes averaging only the pixels they cover
+	 *
+	 * @param pixels Top-down pixels
+	 * @param width Width
+	 * @param height Height
+	 * @param channels Channel count
+	 * @param factorLog2 1 - 2x2 boxes, 2 - 4x4 boxes
+	 * @param out Output, ceil(width / 2^factorLog2) * ceil(height / 2^factorLog2) * channels bytes
+	 */
+	static void DownsampleFlipped(const unsigned char* pixels, int width, int height, int channels, unsigned factorLog2, unsigned char* out);
+
+	/**
+	 * @brief Frees pixels returned by DecodeImage
+	 *
+	 * @param pixels Pixels
+	 */
+	static void FreeImage(unsigned char* pixels);
+
+	/**
+	 * @brief Replaces texture contents with decoded pixels and builds mipmaps
+	 *
+	 * @param texture Texture ID
+	 * @param pixels Pixels, bottom-up rows. With pixelBuffer, a byte offset into it
+	 * @param width Width
+	 * @param height Height
+	 * @param channels Channel count
+	 * @param pixelBuffer Pixel unpack buffer holding the pixels, 0 for client memory.
+	 * Sourcing from a buffer lets the driver return before the copy is done
+	 */
+	static void UploadImage(unsigned texture, const unsigned char* pixels, int width, int height, int channels, unsigned pixelBuffer = 0);
+
+	/**
+	 * @brief Specifies mip levels firstMip to lastMip of a cooked texture
+	 * at their own level and makes firstMip the base level. Other levels
+	 * are untouched, so a texture whose chain already runs from firstMip + 1
+	 * to the end is refined by uploading just firstMip. Needs
+	 * EXT_texture_compression_s3tc
+	 *
+	 * @param texture Texture ID
+	 * @param cooked Parsed cooked texture
+	 * @param firstMip Finest cooked mip to upload
+	 * @param lastMip Coarsest cooked mip to upload
+	 * @param mips Mips firstMip to lastMip as laid out in the file, starting
+	 * at cooked.Mips[firstMip].Offset. With pixelBuffer, a byte offset into it
+	 * @param pixelBuffer Pixel unpack buffer holding the mips, 0 for client memory
+	 */
+	static void UploadCookedMips(unsigned texture, const CookedTexture& cooked, unsigned firstMip, unsigned lastMip, const unsigned char* mips, unsigned pixelBuffer = 0);
+
+	/**
+	 * @brief Raises the base level of a cooked texture past mip and frees
+	 * that level's memory. The coarser levels stay as they are
+	 *
+	 * @param texture Texture ID
+	 * @param mip Current base level
+	 */
+	static void ReleaseMip(unsigned texture, unsigned mip);
+
+	/**
+	 * @brief Replaces texture contents with a single pixel, releasing
+	 * every other level
+	 *
+	 * @param texture Texture ID
+	 * @param pixel RGBA pixel
+	 */
+	static void UploadPlaceholder(unsigned texture, const unsigned char* pixel);
 };
@@ -0,0 +1,156 @@
+#include "texture_array.hpp"
+#include <map>
+#include <iostream>
+#include <algorithm>
+
+// NOTE: Same as the loader's placeholder, reads as neutral under any lighting
+static const unsigned char MISSING_LAYER_VALUE = 128;
+
+// NOTE: Row order doesn't matter, the image is only scaled. Samples at
+// pixel centers so a 2:1 reduction averages each pair
+static void
+resampleBilinear(const unsigned char* src, int width, int height, int channels, unsigned char* dst, int dstWidth, int dstHeight) {
+    float ScaleX = (float)width / dstWidth;
+    float ScaleY = (float)height / dstHeight;
+    for (int Y = 0; Y < dstHeight; ++Y) {
+        float SrcY = std::clamp((Y + 0.5f) * ScaleY - 0.5f, 0.0f, (float)(height - 1));
+        int Y0 = (int)SrcY;
+        int Y1 = std::min(Y0 + 1, height - 1);
+        float FracY = SrcY - Y0;
+        for (int X = 0; X < dstWidth; ++X) {
+            float SrcX = std::clamp((X + 0.5f) * ScaleX - 0.5f, 0.0f, (float)(width - 1));
+            int X0 = (int)SrcX;
+            int X1 = std::min(X0 + 1, width - 1);
+            float FracX = SrcX - X0;
+            for (int Channel = 0; Channel < channels; ++Channel) {
+                float Top = src[((size_t)Y0 * width + X0) * channels + Channel] * (1.0f - FracX)
+                    + src[((size_t)Y0 * width + X1) * channels + Channel] * FracX;
+                float Bottom = src[((size_t)Y1 * width + X0) * channels + Channel] * (1.0f - FracX)
+                    + src[((size_t)Y1 * width + X1) * channels + Channel] * FracX;
+                *dst++ = (unsigned char)(Top + (Bottom - Top) * FracY + 0.5f);
+            }
+        }
+    }
+}
+
+TextureArrayPacker::TextureArrayPacker(int layerSize, TextureQuality quality)
+    : mLayerSize(std::max(layerSize >> quality, 1)), mQuality(quality), mBytes(0) {}
+
+TextureArrayPacker::~TextureArrayPacker() {
+    if (!mArrays.empty()) {
+        glDeleteTextures((GLsizei)mArrays.size(), mArrays.data());
+    }
+}
+
+unsigned
+TextureArrayPacker::Add(const std::string& filePath) {
+    mSources.push_back({ filePath, {}, 0, { 0, 0 } });
+    return (unsigned)mSources.size() - 1;
+}
+
+void
+TextureArrayPacker::decode(Source& source) {
+    int Width;
+    int Height;
+    int Channels;
+    // NOTE: The tier's box filter runs first so the resample has less to read
+    unsigned char* Pixels = Texture::DecodeImage(source.Path, &Width, &Height, &Channels, mQuality);
+    size_t LayerPixels = (size_t)mLayerSize * mLayerSize;
+    if (!Pixels) {
+        std::cerr << "[Warn] Failed to load texture: " << source.Path << ", packing a grey layer" << std::endl;
+        source.Channels = 3;
+        source.Pixels.assign(LayerPixels * source.Channels, MISSING_LAYER_VALUE);
+        return;
+    }
+
+    source.Channels = Channels;
+    source.Pixels.resize(LayerPixels * Channels);
+    if (Width == mLayerSize && Height == mLayerSize) {
+        std::copy(Pixels, Pixels + source.Pixels.size(), source.Pixels.begin());
+    }
+    else {
+        resampleBilinear(Pixels, Width, Height, Channels, source.Pixels.data(), mLayerSize, mLayerSize);
+    }
+    Texture::FreeImage(Pixels);
+}
+
+void
+TextureArrayPacker::Pack(ThreadPool& pool) {
+    // NOTE: The texture loader shares the pool, its decodes aren't waited for
+    JobGroup Jobs(pool);
+    for (Source& Current : mSources) {
+        Source* Job = &Current;
+        Jobs.Submit([this, Job] { decode(*Job); });
+    }
+    Jobs.Wait();
+
+    // NOTE: Sizes all match after resizing, so the format alone decides what shares an array
+    std::map<int, std::vector<Source*>> Groups;
+    for (Source& Current : mSources) {
+        Groups[Current.Channels].push_back(&Current);
+    }
+
+    GLint MaxLayers = 256;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &MaxLayers);
+    for (auto& [Channels, Group] : Groups) {
+        for (size_t First = 0; First < Group.size(); First += MaxLayers) {
+            size_t Last = std::min(Group.size(), First + MaxLayers);
+            upload(std::vector<Source*>(Group.begin() + First, Group.begin() + Last));
+        }
+    }
+
+    std::cout << "Packed " << mSources.size() << " textures into " << mArrays.size() << " texture arrays of "
+        << mLayerSize << "x" << mLayerSize << " (" << mBytes / (1024.0 * 1024.0) << " MB)" << std::endl;
+}
+
+void
+TextureArrayPacker::upload(const std::vector<Source*>& sources) {
+    int Channels = sources.front()->Channels;
+    GLint Format = -1;
+    switch (Channels) {
+    case 1: Format = GL_RED; break;
+    case 3: Format = GL_RGB; break;
+    case 4: Format = GL_RGBA; break;
+    default: Format = GL_RGB; break;
+    }
+
+    unsigned Array;
+    glGenTextures(1, &Array);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, Array);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, Format, mLayerSize, mLayerSize, (GLsizei)sources.size(), 0, Format, GL_UNSIGNED_BYTE, 0);
+    // NOTE: RGB rows of odd widths aren't 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (unsigned LayerIdx = 0; LayerIdx < sources.size(); ++LayerIdx) {
+        Source& Current = *sources[LayerIdx];
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, LayerIdx, mLayerSize, mLayerSize, 1, Format, GL_UNSIGNED_BYTE, Current.Pixels.data());
+        Current.Layer = { Array, LayerIdx };
+        // NOTE: Only needed until the upload, the array keeps its own copy
+        std::vector<unsigned char>().swap(Current.Pixels);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    mArrays.push_back(Array);
+    mBytes += (size_t)mLayerSize * mLayerSize * Channels * sources.size() * 4 / 3;
+}
+
+TextureLayer
+TextureArrayPacker::Get(unsigned index) const {
+    return mSources[index].Layer;
+}
+
+unsigned
+TextureArrayPacker::GetArrayCount() const {
+    return (unsigned)mArrays.size();
+}
+
+size_t
+TextureArrayPacker::GetBytes() const {
+    return mBytes;
+}
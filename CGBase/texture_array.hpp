@@ -0,0 +1,102 @@
+/**
+ * @file texture_array.hpp
+ * @brief Packs textures that share a size and format after resizing into
+ * GL_TEXTURE_2D_ARRAY layers, so objects using them can be drawn with
+ * one texture bind and a layer index each
+ *
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "texture.hpp"
+#include "thread_pool.hpp"
+
+// NOTE: Every packed texture is resized to this, before the quality tier
+static const int TEXTURE_ARRAY_LAYER_SIZE = 1024;
+
+/**
+ * @brief Where a packed texture ended up
+ */
+struct TextureLayer {
+    // NOTE: GL_TEXTURE_2D_ARRAY texture, 0 before Pack
+    unsigned Array;
+    unsigned Layer;
+};
+
+class TextureArrayPacker {
+public:
+    /**
+     * @brief Ctor
+     *
+     * @param layerSize Width and height every texture is resized to
+     * @param quality Tier applied on top of layerSize, see TextureQuality
+     */
+    TextureArrayPacker(int layerSize = TEXTURE_ARRAY_LAYER_SIZE, TextureQuality quality = TEXTURE_QUALITY_FULL);
+
+    /**
+     * @brief Dtor - deletes the arrays, call on the render thread
+     *
+     */
+    ~TextureArrayPacker();
+    TextureArrayPacker(const TextureArrayPacker&) = delete;
+    TextureArrayPacker& operator=(const TextureArrayPacker&) = delete;
+
+    /**
+     * @brief Queues an image for packing
+     *
+     * @param filePath Image file path
+     * @returns Index to look the layer up with after Pack
+     */
+    unsigned Add(const std::string& filePath);
+
+    /**
+     * @brief Decodes and resizes every queued image on the pool, then
+     * uploads one array per channel count, mipmaps included. Images that
+     * fail to decode get a mid grey layer. Call once, on the render thread.
+     * Waits only for its own decode jobs, not for other work on the pool
+     *
+     * @param pool Pool to decode on
+     */
+    void Pack(ThreadPool& pool);
+
+    /**
+     * @brief Array and layer of a queued image
+     *
+     * @param index Index returned by Add
+     */
+    TextureLayer Get(unsigned index) const;
+
+    unsigned GetArrayCount() const;
+
+    /**
+     * @brief GPU bytes of all arrays, mips included
+     *
+     */
+    size_t GetBytes() const;
+private:
+    struct Source {
+        std::string Path;
+        // NOTE: Resized, bottom-up rows
+        std::vector<unsigned char> Pixels;
+        int Channels;
+        TextureLayer Layer;
+    };
+
+    int mLayerSize;
+    TextureQuality mQuality;
+    std::vector<Source> mSources;
+    std::vector<unsigned> mArrays;
+    size_t mBytes;
+
+    /**
+     * @brief Decodes and resizes one source, from a worker
+     */
+    void decode(Source& source);
+
+    /**
+     * @brief Uploads sources into a new array, one layer each
+     */
+    void upload(const std::vector<Source*>& sources);
+};
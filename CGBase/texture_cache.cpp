@@ -0,0 +1,218 @@
+#include "texture_cache.hpp"
+#include <iostream>
+#include <filesystem>
+
+// NOTE: Magenta and black, hard to mistake for a real texture
+static const unsigned char FALLBACK_PIXELS[2 * 2 * 4] = {
+    255, 0, 255, 255,   0, 0, 0, 255,
+    0, 0, 0, 255,       255, 0, 255, 255,
+};
+
+struct TextureHandle::Entry {
+    unsigned Id;
+    unsigned Refs;
+    size_t Bytes;
+    std::string Path;
+    uint64_t ContentHash;
+    // NOTE: Set when this entry shares another entry's texture
+    Entry* Target;
+    bool Pending;
+};
+
+TextureHandle::TextureHandle()
+    : mCache(0), mEntry(0) {}
+
+TextureHandle::TextureHandle(TextureCache* cache, Entry* entry)
+    : mCache(cache), mEntry(entry) {
+    mCache->retain(mEntry);
+}
+
+TextureHandle::TextureHandle(const TextureHandle& other)
+    : mCache(other.mCache), mEntry(other.mEntry) {
+    if (mEntry) {
+        mCache->retain(mEntry);
+    }
+}
+
+TextureHandle&
+TextureHandle::operator=(const TextureHandle& other) {
+    if (other.mEntry) {
+        other.mCache->retain(other.mEntry);
+    }
+    if (mEntry) {
+        mCache->release(mEntry);
+    }
+    mCache = other.mCache;
+    mEntry = other.mEntry;
+    return *this;
+}
+
+TextureHandle::~TextureHandle() {
+    if (mEntry) {
+        mCache->release(mEntry);
+    }
+}
+
+unsigned
+TextureHandle::GetId() const {
+    return mEntry ? mEntry->Id : 0;
+}
+
+TextureHandle::operator bool() const {
+    return mEntry != 0;
+}
+
+TextureCache::TextureCache(TextureLoader& loader)
+    : mLoader(loader), mTextureCount(0), mHits(0), mMisses(0) {
+    unsigned FallbackTexture;
+    glGenTextures(1, &FallbackTexture);
+    glBindTexture(GL_TEXTURE_2D, FallbackTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, FALLBACK_PIXELS);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // NOTE: The cache itself holds one reference, so the fallback lives as long as it does
+    mFallback = new TextureHandle::Entry{ FallbackTexture, 1, sizeof(FALLBACK_PIXELS), "<fallback>", 0, 0, false };
+    ++mTextureCount;
+
+    mLoader.SetDecodedCallback([this](const TextureLoader::DecodedInfo& info) {
+        return onDecoded(info);
+    });
+}
+
+TextureCache::~TextureCache() {
+    mLoader.SetDecodedCallback(nullptr);
+    // NOTE: Entries still referenced by handles outliving the cache leak
+    // their GL textures rather than dangle
+    release(mFallback);
+}
+
+TextureHandle
+TextureCache::Load(const std::string& filePath) {
+    std::error_code Error;
+    std::string Key = std::filesystem::weakly_canonical(filePath, Error).generic_string();
+    if (Error) {
+        Key = filePath;
+    }
+
+    auto Found = mByPath.find(Key);
+    if (Found != mByPath.end()) {
+        ++mHits;
+        return TextureHandle(this, Found->second);
+    }
+
+    ++mMisses;
+    TextureHandle::Entry* Created = new TextureHandle::Entry{ 0, 0, 0, Key, 0, 0, true };
+    Created->Id = mLoader.Load(filePath);
+    mByPath[Key] = Created;
+    mPending[Created->Id] = Created;
+    return TextureHandle(this, Created);
+}
+
+TextureHandle
+TextureCache::GetFallback() {
+    return TextureHandle(this, mFallback);
+}
+
+size_t
+TextureCache::GetResidentBytes() const {
+    // NOTE: The fallback isn't the loader's, everything else is tracked there
+    return mLoader.GetResidency().GetResidentBytes() + mFallback->Bytes;
+}
+
+unsigned
+TextureCache::GetHitCount() const {
+    return mHits;
+}
+
+unsigned
+TextureCache::GetMissCount() const {
+    return mMisses;
+}
+
+void
+TextureCache::PrintStats() const {
+    std::cout << "Texture cache: " << mTextureCount << " textures, " << GetResidentBytes() / (1024.0 * 1024.0)
+        << " MB resident, " << mHits << " hits, " << mMisses << " misses" << std::endl;
+}
+
+bool
+TextureCache::onDecoded(const TextureLoader::DecodedInfo& info) {
+    auto Found = mPending.find(info.Texture);
+    if (Found == mPending.end()) {
+        return true;
+    }
+
+    TextureHandle::Entry* Loaded = Found->second;
+    mPending.erase(Found);
+    Loaded->Pending = false;
+
+    // NOTE: Every handle went away while it was loading
+    if (!Loaded->Refs) {
+        Loaded->Refs = 1;
+        release(Loaded);
+        return false;
+    }
+
+    if (info.Failed) {
+        redirect(Loaded, mFallback);
+        return false;
+    }
+
+    auto SameContent = mByContent.find(info.ContentHash);
+    if (SameContent != mByContent.end()) {
+        ++mHits;
+        redirect(Loaded, SameContent->second);
+        return false;
+    }
+
+    Loaded->ContentHash = info.ContentHash;
+    Loaded->Bytes = info.Bytes;
+    mByContent[info.ContentHash] = Loaded;
+    ++mTextureCount;
+    return true;
+}
+
+void
+TextureCache::redirect(TextureHandle::Entry* entry, TextureHandle::Entry* target) {
+    glDeleteTextures(1, &entry->Id);
+    entry->Id = target->Id;
+    entry->Target = target;
+    retain(target);
+}
+
+void
+TextureCache::retain(TextureHandle::Entry* entry) {
+    ++entry->Refs;
+}
+
+void
+TextureCache::release(TextureHandle::Entry* entry) {
+    if (--entry->Refs) {
+        return;
+    }
+    // NOTE: The loader still owns the GL name, onDecoded finishes the release
+    if (entry->Pending) {
+        return;
+    }
+
+    mByPath.erase(entry->Path);
+    if (entry->Target) {
+        release(entry->Target);
+    }
+    else {
+        if (entry->ContentHash) {
+            mByContent.erase(entry->ContentHash);
+        }
+        mLoader.Forget(entry->Id);
+        glDeleteTextures(1, &entry->Id);
+        // NOTE: Only uploaded textures were counted
+        if (entry->Bytes) {
+            --mTextureCount;
+        }
+    }
+    delete entry;
+}
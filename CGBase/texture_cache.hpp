@@ -0,0 +1,108 @@
+/**
+ * @file texture_cache.hpp
+ * @brief Deduplicating texture cache with refcounted handles
+ *
+ */
+
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include <GL/glew.h>
+#include "texture_loader.hpp"
+
+class TextureCache;
+
+/**
+ * @brief Shared reference to a cached texture. The GL texture is deleted
+ * when the last handle goes away. Only copy and destroy on the render thread
+ */
+class TextureHandle {
+public:
+    TextureHandle();
+    TextureHandle(const TextureHandle& other);
+    TextureHandle& operator=(const TextureHandle& other);
+    ~TextureHandle();
+
+    /**
+     * @brief Current GL texture. May change once when a duplicate or
+     * failed image is redirected, so fetch it at draw time
+     *
+     * @returns TextureID, 0 for an empty handle
+     */
+    unsigned GetId() const;
+
+    explicit operator bool() const;
+private:
+    friend class TextureCache;
+    struct Entry;
+
+    TextureCache* mCache;
+    Entry* mEntry;
+
+    TextureHandle(TextureCache* cache, Entry* entry);
+};
+
+class TextureCache {
+public:
+    /**
+     * @brief Ctor - creates the fallback texture and takes over the
+     * loader's decoded callback
+     *
+     * @param loader Loader used for misses, must outlive the cache
+     */
+    TextureCache(TextureLoader& loader);
+    ~TextureCache();
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    /**
+     * @brief Returns the texture for given image, loading it on a miss.
+     * Paths are compared canonically, and files with identical contents
+     * share one GL texture once decoded
+     *
+     * @param filePath Image file path
+     * @returns Handle, shows a placeholder until the image is uploaded
+     */
+    TextureHandle Load(const std::string& filePath);
+
+    /**
+     * @brief Checkerboard texture used for images that fail to load
+     *
+     */
+    TextureHandle GetFallback();
+
+    /**
+     * @brief Approximate GPU memory of all resident textures, mipmaps
+     * included. Follows evictions and streaming, as tracked by the
+     * loader's TextureResidency
+     *
+     */
+    size_t GetResidentBytes() const;
+    unsigned GetHitCount() const;
+    unsigned GetMissCount() const;
+
+    /**
+     * @brief Logs resident bytes, texture count and hit/miss counts
+     *
+     */
+    void PrintStats() const;
+private:
+    friend class TextureHandle;
+
+    TextureLoader& mLoader;
+    std::unordered_map<std::string, TextureHandle::Entry*> mByPath;
+    std::unordered_map<uint64_t, TextureHandle::Entry*> mByContent;
+    // NOTE: Entries whose image is still being loaded, by their GL texture
+    std::unordered_map<unsigned, TextureHandle::Entry*> mPending;
+    TextureHandle::Entry* mFallback;
+    unsigned mTextureCount;
+    unsigned mHits;
+    unsigned mMisses;
+
+    bool onDecoded(const TextureLoader::DecodedInfo& info);
+    void redirect(TextureHandle::Entry* entry, TextureHandle::Entry* target);
+    void retain(TextureHandle::Entry* entry);
+    void release(TextureHandle::Entry* entry);
+};
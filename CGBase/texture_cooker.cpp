@@ -0,0 +1,338 @@
+#include "texture_cooker.hpp"
+#include "cooked_texture.hpp"
+#include "texture.hpp"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COOKER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// NOTE: Block rows handed to one pool job
+static const unsigned BLOCK_ROWS_PER_JOB = 8;
+
+static uint16_t
+toRGB565(int r, int g, int b) {
+    return (uint16_t)((((r * 31 + 127) / 255) << 11) | (((g * 63 + 127) / 255) << 5) | ((b * 31 + 127) / 255));
+}
+
+static void
+fromRGB565(uint16_t color, int* rgb) {
+    int R = (color >> 11) & 31;
+    int G = (color >> 5) & 63;
+    int B = color & 31;
+    rgb[0] = (R << 3) | (R >> 2);
+    rgb[1] = (G << 2) | (G >> 4);
+    rgb[2] = (B << 3) | (B >> 2);
+}
+
+// NOTE: Per channel min and max over the block, RGBA packed into 4 bytes each
+static void
+blockBounds(const unsigned char* block, unsigned char* minimum, unsigned char* maximum) {
+#ifdef COOKER_SSE2
+    __m128i Row0 = _mm_loadu_si128((const __m128i*)(block + 0));
+    __m128i Row1 = _mm_loadu_si128((const __m128i*)(block + 16));
+    __m128i Row2 = _mm_loadu_si128((const __m128i*)(block + 32));
+    __m128i Row3 = _mm_loadu_si128((const __m128i*)(block + 48));
+    __m128i Lo = _mm_min_epu8(_mm_min_epu8(Row0, Row1), _mm_min_epu8(Row2, Row3));
+    __m128i Hi = _mm_max_epu8(_mm_max_epu8(Row0, Row1), _mm_max_epu8(Row2, Row3));
+    // NOTE: Fold the four pixels of each register onto the first one
+    Lo = _mm_min_epu8(Lo, _mm_shuffle_epi32(Lo, _MM_SHUFFLE(1, 0, 3, 2)));
+    Lo = _mm_min_epu8(Lo, _mm_shuffle_epi32(Lo, _MM_SHUFFLE(2, 3, 0, 1)));
+    Hi = _mm_max_epu8(Hi, _mm_shuffle_epi32(Hi, _MM_SHUFFLE(1, 0, 3, 2)));
+    Hi = _mm_max_epu8(Hi, _mm_shuffle_epi32(Hi, _MM_SHUFFLE(2, 3, 0, 1)));
+    int Min = _mm_cvtsi128_si32(Lo);
+    int Max = _mm_cvtsi128_si32(Hi);
+    std::memcpy(minimum, &Min, 4);
+    std::memcpy(maximum, &Max, 4);
+#else
+    for (int Channel = 0; Channel < 4; ++Channel) {
+        minimum[Channel] = maximum[Channel] = block[Channel];
+    }
+    for (int PixelIdx = 1; PixelIdx < 16; ++PixelIdx) {
+        for (int Channel = 0; Channel < 4; ++Channel) {
+            minimum[Channel] = std::min(minimum[Channel], block[PixelIdx * 4 + Channel]);
+            maximum[Channel] = std::max(maximum[Channel], block[PixelIdx * 4 + Channel]);
+        }
+    }
+#endif
+}
+
+// NOTE: Projection of each pixel onto the endpoint axis, relative to the second endpoint
+static void
+projectBlock(const unsigned char* block, const int* axis, int base, int* projections) {
+#ifdef COOKER_SSE2
+    __m128i Zero = _mm_setzero_si128();
+    __m128i Axis = _mm_set_epi16(0, (short)axis[2], (short)axis[1], (short)axis[0], 0, (short)axis[2], (short)axis[1], (short)axis[0]);
+    __m128i Base = _mm_set1_epi32(base);
+    for (int RowIdx = 0; RowIdx < 4; ++RowIdx) {
+        __m128i Row = _mm_loadu_si128((const __m128i*)(block + RowIdx * 16));
+        // NOTE: [R*Ar + G*Ag, B*Ab] per pixel, then summed pairwise
+        __m128i Lo = _mm_madd_epi16(_mm_unpacklo_epi8(Row, Zero), Axis);
+        __m128i Hi = _mm_madd_epi16(_mm_unpackhi_epi8(Row, Zero), Axis);
+        Lo = _mm_add_epi32(Lo, _mm_shuffle_epi32(Lo, _MM_SHUFFLE(2, 3, 0, 1)));
+        Hi = _mm_add_epi32(Hi, _mm_shuffle_epi32(Hi, _MM_SHUFFLE(2, 3, 0, 1)));
+        __m128i Dots = _mm_unpacklo_epi64(_mm_shuffle_epi32(Lo, _MM_SHUFFLE(3, 3, 2, 0)), _mm_shuffle_epi32(Hi, _MM_SHUFFLE(3, 3, 2, 0)));
+        _mm_storeu_si128((__m128i*)(projections + RowIdx * 4), _mm_sub_epi32(Dots, Base));
+    }
+#else
+    for (int PixelIdx = 0; PixelIdx < 16; ++PixelIdx) {
+        const unsigned char* Pixel = block + PixelIdx * 4;
+        projections[PixelIdx] = Pixel[0] * axis[0] + Pixel[1] * axis[1] + Pixel[2] * axis[2] - base;
+    }
+#endif
+}
+
+static void
+encodeColor(const unsigned char* block, const unsigned char* minimum, const unsigned char* maximum, unsigned char* out) {
+    int Low[3];
+    int High[3];
+    for (int Channel = 0; Channel < 3; ++Channel) {
+        // NOTE: Inset the bounding box, extremes are usually outliers
+        int Inset = (maximum[Channel] - minimum[Channel]) >> 4;
+        Low[Channel] = minimum[Channel] + Inset;
+        High[Channel] = maximum[Channel] - Inset;
+    }
+
+    uint16_t Color0 = toRGB565(High[0], High[1], High[2]);
+    uint16_t Color1 = toRGB565(Low[0], Low[1], Low[2]);
+    if (Color0 < Color1) {
+        std::swap(Color0, Color1);
+    }
+    out[0] = Color0 & 0xFF;
+    out[1] = Color0 >> 8;
+    out[2] = Color1 & 0xFF;
+    out[3] = Color1 >> 8;
+    if (Color0 == Color1) {
+        std::memset(out + 4, 0, 4);
+        return;
+    }
+
+    int Palette0[3];
+    int Palette1[3];
+    fromRGB565(Color0, Palette0);
+    fromRGB565(Color1, Palette1);
+    int Axis[3] = { Palette0[0] - Palette1[0], Palette0[1] - Palette1[1], Palette0[2] - Palette1[2] };
+    int AxisLengthSq = Axis[0] * Axis[0] + Axis[1] * Axis[1] + Axis[2] * Axis[2];
+    int Base = Palette1[0] * Axis[0] + Palette1[1] * Axis[1] + Palette1[2] * Axis[2];
+
+    int Projections[16];
+    projectBlock(block, Axis, Base, Projections);
+
+    // NOTE: Palette order is color0, color1, 2/3 color0 + 1/3 color1, 1/3 color0 + 2/3 color1.
+    // Indexed by how many of the 1/6, 3/6 and 5/6 thresholds the pixel passes
+    static const uint32_t INDEX_BY_STEP[4] = { 1, 3, 2, 0 };
+    uint32_t Indices = 0;
+    for (int PixelIdx = 0; PixelIdx < 16; ++PixelIdx) {
+        int Scaled = Projections[PixelIdx] * 6;
+        int Step = (Scaled >= AxisLengthSq) + (Scaled >= 3 * AxisLengthSq) + (Scaled >= 5 * AxisLengthSq);
+        Indices |= INDEX_BY_STEP[Step] << (PixelIdx * 2);
+    }
+    std::memcpy(out + 4, &Indices, 4);
+}
+
+static void
+encodeAlpha(const unsigned char* block, unsigned char minimum, unsigned char maximum, unsigned char* out) {
+    out[0] = maximum;
+    out[1] = minimum;
+    std::memset(out + 2, 0, 6);
+    if (maximum == minimum) {
+        return;
+    }
+
+    // NOTE: 8 alpha mode: alpha0, alpha1, then 6/7 .. 1/7 of alpha0.
+    // Step 7 is alpha0, step 0 is alpha1
+    int Range = maximum - minimum;
+    uint64_t Indices = 0;
+    for (int PixelIdx = 0; PixelIdx < 16; ++PixelIdx) {
+        int Step = ((block[PixelIdx * 4 + 3] - minimum) * 14 + Range) / (2 * Range);
+        uint64_t Index = Step == 7 ? 0 : Step == 0 ? 1 : 8 - Step;
+        Indices |= Index << (PixelIdx * 3);
+    }
+    for (int ByteIdx = 0; ByteIdx < 6; ++ByteIdx) {
+        out[2 + ByteIdx] = (unsigned char)(Indices >> (ByteIdx * 8));
+    }
+}
+
+void
+TextureCooker::EncodeBC1Block(const unsigned char* block, unsigned char* out) {
+    unsigned char Minimum[4];
+    unsigned char Maximum[4];
+    blockBounds(block, Minimum, Maximum);
+    encodeColor(block, Minimum, Maximum, out);
+}
+
+void
+TextureCooker::EncodeBC3Block(const unsigned char* block, unsigned char* out) {
+    unsigned char Minimum[4];
+    unsigned char Maximum[4];
+    blockBounds(block, Minimum, Maximum);
+    encodeAlpha(block, Minimum[3], Maximum[3], out);
+    encodeColor(block, Minimum, Maximum, out + 8);
+}
+
+TextureCooker::TextureCooker(ThreadPool& pool)
+    : mPool(pool), mUncompressedBytes(0), mCookedBytes(0) {}
+
+void
+TextureCooker::encodeImage(JobGroup& group, const unsigned char* pixels, unsigned width, unsigned height, bool alpha, std::vector<unsigned char>& out) {
+    unsigned BlocksX = (width + 3) / 4;
+    unsigned BlocksY = (height + 3) / 4;
+    unsigned BlockSize = alpha ? 16 : 8;
+    out.resize((size_t)BlocksX * BlocksY * BlockSize);
+
+    unsigned char* Out = out.data();
+    for (unsigned FirstRow = 0; FirstRow < BlocksY; FirstRow += BLOCK_ROWS_PER_JOB) {
+        unsigned LastRow = std::min(BlocksY, FirstRow + BLOCK_ROWS_PER_JOB);
+        group.Submit([=] {
+            unsigned char Block[64];
+            for (unsigned BlockY = FirstRow; BlockY < LastRow; ++BlockY) {
+                for (unsigned BlockX = 0; BlockX < BlocksX; ++BlockX) {
+                    // NOTE: Edge blocks of non multiple of 4 sizes repeat the last row/column
+                    for (unsigned Y = 0; Y < 4; ++Y) {
+                        unsigned SourceY = std::min(BlockY * 4 + Y, height - 1);
+                        for (unsigned X = 0; X < 4; ++X) {
+                            unsigned SourceX = std::min(BlockX * 4 + X, width - 1);
+                            std::memcpy(Block + (Y * 4 + X) * 4, pixels + ((size_t)SourceY * width + SourceX) * 4, 4);
+                        }
+                    }
+                    unsigned char* Destination = Out + ((size_t)BlockY * BlocksX + BlockX) * BlockSize;
+                    if (alpha) {
+                        EncodeBC3Block(Block, Destination);
+                    }
+                    else {
+                        EncodeBC1Block(Block, Destination);
+                    }
+                }
+            }
+        });
+    }
+}
+
+bool
+TextureCooker::Cook(const std::string& sourcePath, const std::string& cookedPath) {
+    int Width;
+    int Height;
+    int Channels;
+    unsigned char* Source = Texture::DecodeImage(sourcePath, &Width, &Height, &Channels);
+    if (!Source) {
+        std::cerr << "[Err] Failed to decode " << sourcePath << std::endl;
+        return false;
+    }
+
+    std::vector<unsigned char> Pixels((size_t)Width * Height * 4);
+    bool Alpha = false;
+    for (size_t PixelIdx = 0; PixelIdx < (size_t)Width * Height; ++PixelIdx) {
+        const unsigned char* In = Source + PixelIdx * Channels;
+        unsigned char* Out = Pixels.data() + PixelIdx * 4;
+        Out[0] = In[0];
+        Out[1] = Channels >= 3 ? In[1] : In[0];
+        Out[2] = Channels >= 3 ? In[2] : In[0];
+        Out[3] = Channels == 4 ? In[3] : Channels == 2 ? In[1] : 255;
+        Alpha = Alpha || Out[3] != 255;
+    }
+    Texture::FreeImage(Source);
+
+    // NOTE: Every level is encoded in one group and waited for once, so jobs
+    // of the small levels overlap the larger ones. Pixels of each level are
+    // kept until then, the reserves keep the buffers jobs write from moving
+    JobGroup Encoding(mPool);
+    std::vector<CookedTextureMip> Mips;
+    std::vector<std::vector<unsigned char>> MipData;
+    std::vector<std::vector<unsigned char>> Levels;
+    MipData.reserve(COOKED_TEXTURE_MAX_MIPS);
+    Levels.reserve(COOKED_TEXTURE_MAX_MIPS);
+    Levels.push_back(std::move(Pixels));
+    unsigned MipWidth = Width;
+    unsigned MipHeight = Height;
+    uint32_t Offset = 0;
+    for (;;) {
+        const std::vector<unsigned char>& Level = Levels.back();
+        MipData.emplace_back();
+        encodeImage(Encoding, Level.data(), MipWidth, MipHeight, Alpha, MipData.back());
+        Mips.push_back({ 0, (uint32_t)MipData.back().size(), MipWidth, MipHeight });
+        if ((MipWidth == 1 && MipHeight == 1) || Mips.size() == COOKED_TEXTURE_MAX_MIPS) {
+            break;
+        }
+
+        // NOTE: 2x2 box filter, odd sizes reuse the last row/column
+        unsigned NextWidth = std::max(1u, MipWidth / 2);
+        unsigned NextHeight = std::max(1u, MipHeight / 2);
+        std::vector<unsigned char> Next((size_t)NextWidth * NextHeight * 4);
+        for (unsigned Y = 0; Y < NextHeight; ++Y) {
+            unsigned Y0 = std::min(Y * 2, MipHeight - 1);
+            unsigned Y1 = std::min(Y * 2 + 1, MipHeight - 1);
+            for (unsigned X = 0; X < NextWidth; ++X) {
+                unsigned X0 = std::min(X * 2, MipWidth - 1);
+                unsigned X1 = std::min(X * 2 + 1, MipWidth - 1);
+                for (int Channel = 0; Channel < 4; ++Channel) {
+                    int Sum = Level[((size_t)Y0 * MipWidth + X0) * 4 + Channel] + Level[((size_t)Y0 * MipWidth + X1) * 4 + Channel]
+                        + Level[((size_t)Y1 * MipWidth + X0) * 4 + Channel] + Level[((size_t)Y1 * MipWidth + X1) * 4 + Channel];
+                    Next[((size_t)Y * NextWidth + X) * 4 + Channel] = (unsigned char)((Sum + 2) / 4);
+                }
+            }
+        }
+        Levels.push_back(std::move(Next));
+        MipWidth = NextWidth;
+        MipHeight = NextHeight;
+    }
+    Encoding.Wait();
+
+    CookedTextureHeader Header = { COOKED_TEXTURE_MAGIC, COOKED_TEXTURE_VERSION,
+        Alpha ? (uint32_t)GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : (uint32_t)GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+        (uint32_t)Width, (uint32_t)Height, (uint32_t)Mips.size() };
+    Offset = sizeof(Header) + Mips.size() * sizeof(CookedTextureMip);
+    size_t CookedBytes = 0;
+    for (CookedTextureMip& Mip : Mips) {
+        Offset = (Offset + COOKED_TEXTURE_MIP_ALIGNMENT - 1) / COOKED_TEXTURE_MIP_ALIGNMENT * COOKED_TEXTURE_MIP_ALIGNMENT;
+        Mip.Offset = Offset;
+        Offset += Mip.Size;
+        CookedBytes += Mip.Size;
+    }
+
+    std::error_code Error;
+    std::filesystem::create_directories(std::filesystem::path(cookedPath).parent_path(), Error);
+    std::ofstream Out(cookedPath, std::ios::binary | std::ios::trunc);
+    if (!Out) {
+        std::cerr << "[Err] Failed to write " << cookedPath << std::endl;
+        return false;
+    }
+
+    Out.write((const char*)&Header, sizeof(Header));
+    Out.write((const char*)Mips.data(), Mips.size() * sizeof(CookedTextureMip));
+    for (size_t MipIdx = 0; MipIdx < Mips.size(); ++MipIdx) {
+        std::vector<char> Padding(Mips[MipIdx].Offset - (size_t)Out.tellp(), 0);
+        Out.write(Padding.data(), Padding.size());
+        Out.write((const char*)MipData[MipIdx].data(), MipData[MipIdx].size());
+    }
+
+    size_t UncompressedBytes = (size_t)Width * Height * 4 * 4 / 3;
+    mUncompressedBytes += UncompressedBytes;
+    mCookedBytes += CookedBytes;
+    std::cout << "Cooked " << sourcePath << " -> " << cookedPath << " (" << Width << "x" << Height << ", "
+        << (Alpha ? "BC3" : "BC1") << ", " << Mips.size() << " mips, " << (double)UncompressedBytes / CookedBytes << "x smaller)" << std::endl;
+    return true;
+}
+
+unsigned
+TextureCooker::CookDirectory(const std::string& directory) {
+    static const std::vector<std::string> SOURCE_EXTENSIONS = { ".jpg", ".jpeg", ".png", ".tga", ".bmp" };
+    unsigned Cooked = 0;
+    for (const std::string& SourcePath : FindFilesWithExtensions(directory, SOURCE_EXTENSIONS)) {
+        Cooked += Cook(SourcePath, GetCookedTexturePath(SourcePath));
+    }
+    return Cooked;
+}
+
+size_t
+TextureCooker::GetUncompressedBytes() const {
+    return mUncompressedBytes;
+}
+
+size_t
+TextureCooker::GetCookedBytes() const {
+    return mCookedBytes;
+}
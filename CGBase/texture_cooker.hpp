@@ -0,0 +1,88 @@
+/**
+ * @file texture_cooker.hpp
+ * @brief Offline conversion of source images into cooked textures: full
+ * mip chain, BC1 (opaque) or BC3 (with alpha) compressed
+ *
+ */
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "thread_pool.hpp"
+
+class TextureCooker {
+public:
+    /**
+     * @brief Ctor
+     *
+     * @param pool Pool block compression is spread over
+     */
+    TextureCooker(ThreadPool& pool);
+
+    /**
+     * @brief Cooks one image
+     *
+     * @param sourcePath Source image path
+     * @param cookedPath Output path, directories are created as needed
+     *
+     * @returns true - Success, false - Failure
+     */
+    bool Cook(const std::string& sourcePath, const std::string& cookedPath);
+
+    /**
+     * @brief Cooks every image under directory (recursively) to
+     * GetCookedTexturePath of its path
+     *
+     * @param directory Directory, relative to the working directory
+     *
+     * @returns Number of images cooked
+     */
+    unsigned CookDirectory(const std::string& directory);
+
+    /**
+     * @brief GPU bytes the cooked images would take if uploaded the old
+     * way (8 bits per channel, padded to 4 bytes per pixel, mipmapped)
+     *
+     */
+    size_t GetUncompressedBytes() const;
+
+    /**
+     * @brief GPU bytes of everything cooked so far
+     *
+     */
+    size_t GetCookedBytes() const;
+
+    /**
+     * @brief Compresses one 4x4 block of RGBA pixels to BC1
+     *
+     * @param block 16 RGBA pixels, row by row
+     * @param out 8 bytes
+     */
+    static void EncodeBC1Block(const unsigned char* block, unsigned char* out);
+
+    /**
+     * @brief Compresses one 4x4 block of RGBA pixels to BC3
+     *
+     * @param block 16 RGBA pixels, row by row
+     * @param out 16 bytes
+     */
+    static void EncodeBC3Block(const unsigned char* block, unsigned char* out);
+private:
+    ThreadPool& mPool;
+    size_t mUncompressedBytes;
+    size_t mCookedBytes;
+
+    /**
+     * @brief Submits compression of a whole RGBA image, block rows spread
+     * over the pool. Pixels and out must stay put until group is waited for
+     *
+     * @param group Group the jobs are counted in
+     * @param pixels RGBA pixels
+     * @param width Width
+     * @param height Height
+     * @param alpha BC3 if true, BC1 otherwise
+     * @param out Compressed blocks, resized to fit
+     */
+    void encodeImage(JobGroup& group, const unsigned char* pixels, unsigned width, unsigned height, bool alpha, std::vector<unsigned char>& out);
+};
@@ -0,0 +1,154 @@
+#include "texture_decoder.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <algorithm>
+
+#if defined(__has_include)
+#if __has_include(<turbojpeg.h>)
+#define TEXTURE_TURBOJPEG 1
+#include <turbojpeg.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "turbojpeg.lib")
+#endif
+#endif
+#endif
+
+// NOTE: Box filters only handle 4x4 at most, sums must fit 16 bits
+static const unsigned MAX_DOWNSAMPLE_LOG2 = 2;
+
+// NOTE: Flips freshly decoded pixels, or replaces them with a downsampled
+// and flipped copy when the quality tier asks for it
+static unsigned char*
+flipOrDownsample(unsigned char* imageData, int* width, int* height, int channels, TextureQuality quality) {
+    unsigned FactorLog2 = std::min((unsigned)quality, MAX_DOWNSAMPLE_LOG2);
+    if (!FactorLog2) {
+        //Loaded upside-down => flip!
+        stbi__vertical_flip(imageData, *width, *height, channels);
+        return imageData;
+    }
+
+    // NOTE: Rounds up, same as TJSCALED on the libjpeg-turbo path
+    int OutWidth = (*width + (1 << FactorLog2) - 1) >> FactorLog2;
+    int OutHeight = (*height + (1 << FactorLog2) - 1) >> FactorLog2;
+    // NOTE: Same allocator as stb so FreeImage works on either
+    unsigned char* Downsampled = (unsigned char*)STBI_MALLOC((size_t)OutWidth * OutHeight * channels);
+    if (!Downsampled) {
+        stbi__vertical_flip(imageData, *width, *height, channels);
+        return imageData;
+    }
+
+    Texture::DownsampleFlipped(imageData, *width, *height, channels, FactorLog2, Downsampled);
+    stbi_image_free(imageData);
+    *width = OutWidth;
+    *height = OutHeight;
+    return Downsampled;
+}
+
+class StbImageDecoder : public ImageDecoder {
+public:
+    const char*
+    GetName() const override {
+        return "stb_image";
+    }
+
+    bool
+    CanDecode(const unsigned char* data, size_t size) const override {
+        return true;
+    }
+
+    unsigned char*
+    Decode(const unsigned char* data, size_t size, int* width, int* height, int* channels, TextureQuality quality) const override {
+        unsigned char* ImageData = stbi_load_from_memory(data, (int)size, width, height, channels, 0);
+        if (!ImageData) {
+            return 0;
+        }
+
+        return flipOrDownsample(ImageData, width, height, *channels, quality);
+    }
+};
+
+#ifdef TEXTURE_TURBOJPEG
+class TurboJpegDecoder : public ImageDecoder {
+public:
+    const char*
+    GetName() const override {
+        return "libjpeg-turbo";
+    }
+
+    bool
+    CanDecode(const unsigned char* data, size_t size) const override {
+        return size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF;
+    }
+
+    unsigned char*
+    Decode(const unsigned char* data, size_t size, int* width, int* height, int* channels, TextureQuality quality) const override {
+        tjhandle Handle = getHandle();
+        int Width;
+        int Height;
+        int Subsampling;
+        int Colorspace;
+        if (!Handle || (tjDecompressHeader3(Handle, data, (unsigned long)size, &Width, &Height, &Subsampling, &Colorspace) < 0 && !isWarning(Handle))) {
+            return 0;
+        }
+
+        // NOTE: Tiers are applied by the IDCT itself, it skips the
+        // frequencies a smaller image can't show instead of filtering afterwards
+        tjscalingfactor Scale = { 1, 1 << std::min((unsigned)quality, MAX_DOWNSAMPLE_LOG2) };
+        int OutWidth = TJSCALED(Width, Scale);
+        int OutHeight = TJSCALED(Height, Scale);
+        // NOTE: Matches the channel count stb_image gives the same file
+        bool Gray = Colorspace == TJCS_GRAY;
+        int PixelFormat = Gray ? TJPF_GRAY : TJPF_RGB;
+        int Channels = Gray ? 1 : 3;
+        unsigned char* Pixels = (unsigned char*)STBI_MALLOC((size_t)OutWidth * OutHeight * Channels);
+        if (!Pixels) {
+            return 0;
+        }
+
+        // NOTE: Rows come out bottom-up, there's no separate flip
+        if (tjDecompress2(Handle, data, (unsigned long)size, Pixels, OutWidth, 0, OutHeight, PixelFormat, TJFLAG_BOTTOMUP) < 0 && !isWarning(Handle)) {
+            STBI_FREE(Pixels);
+            return 0;
+        }
+
+        *width = OutWidth;
+        *height = OutHeight;
+        *channels = Channels;
+        return Pixels;
+    }
+private:
+    // NOTE: Corrupt data warnings, extraneous bytes before a marker and
+    // such, still leave the whole image decoded
+    static bool
+    isWarning(tjhandle handle) {
+        return tjGetErrorCode(handle) == TJERR_WARNING;
+    }
+
+    // NOTE: Handles aren't thread safe, each decoding thread keeps its own
+    static tjhandle
+    getHandle() {
+        struct Owner {
+            tjhandle Handle = tjInitDecompress();
+            ~Owner() {
+                if (Handle) {
+                    tjDestroy(Handle);
+                }
+            }
+        };
+        thread_local Owner Current;
+        return Current.Handle;
+    }
+};
+#endif
+
+const std::vector<const ImageDecoder*>&
+GetImageDecoders() {
+    static const StbImageDecoder Stb;
+#ifdef TEXTURE_TURBOJPEG
+    static const TurboJpegDecoder TurboJpeg;
+    static const std::vector<const ImageDecoder*> Decoders = { &TurboJpeg, &Stb };
+#else
+    static const std::vector<const ImageDecoder*> Decoders = { &Stb };
+#endif
+    return Decoders;
+}
@@ -0,0 +1,53 @@
+/**
+ * @file texture_decoder.hpp
+ * @brief Image decoding backends behind Texture::DecodeImage. stb_image
+ * handles every format, libjpeg-turbo takes over JPEGs when it's
+ * available at build time
+ *
+ */
+
+#pragma once
+#include <vector>
+#include <cstddef>
+#include "texture.hpp"
+
+class ImageDecoder {
+public:
+    virtual ~ImageDecoder() = default;
+
+    /**
+     * @brief Backend name, for logs and the decode benchmark
+     */
+    virtual const char* GetName() const = 0;
+
+    /**
+     * @brief Whether the backend understands the encoded data, judged by its signature
+     *
+     * @param data Encoded file contents
+     * @param size Size in bytes
+     */
+    virtual bool CanDecode(const unsigned char* data, size_t size) const = 0;
+
+    /**
+     * @brief Decodes into GL's bottom-up row order, reduced by the quality
+     * tier. Touches no GL state, safe to call from any thread
+     *
+     * @param data Encoded file contents
+     * @param size Size in bytes
+     * @param width Output width
+     * @param height Output height
+     * @param channels Output channel count
+     * @param quality Tier to reduce the image by, each side becomes
+     * ceil(size / 2^tier) in every backend so sizes don't depend on which one decoded it
+     * @returns Pixels, free with Texture::FreeImage. nullptr on failure,
+     * Texture::DecodeImageFromMemory then tries the next backend
+     */
+    virtual unsigned char* Decode(const unsigned char* data, size_t size, int* width, int* height, int* channels,
+        TextureQuality quality) const = 0;
+};
+
+/**
+ * @brief Every backend built in, preferred first. stb_image is always last
+ *
+ */
+const std::vector<const ImageDecoder*>& GetImageDecoders();
@@ -0,0 +1,469 @@
+#include "texture_loader.hpp"
+#include "texture.hpp"
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <filesystem>
+#include <algorithm>
+
+// NOTE: Mid grey reads as neutral under any lighting while the real image loads
+static const unsigned char PLACEHOLDER_PIXEL[4] = { 128, 128, 128, 255 };
+
+// NOTE: Also the first touch of every page of a fresh mapping, so the
+// render thread doesn't page fault during the upload
+static uint64_t
+hashContent(const unsigned char* data, size_t size) {
+    uint64_t Hash = 14695981039346656037ull;
+    for (size_t ByteIdx = 0; ByteIdx < size; ++ByteIdx) {
+        Hash ^= data[ByteIdx];
+        Hash *= 1099511628211ull;
+    }
+    return Hash;
+}
+
+// NOTE: Cooked file of the source, if it's there and up to date
+static bool
+mapCooked(const std::string& filePath, MappedFile& cooked) {
+    std::string CookedPath = GetCookedTexturePath(filePath);
+    std::error_code Error;
+    auto CookedTime = std::filesystem::last_write_time(CookedPath, Error);
+    if (Error) {
+        return false;
+    }
+    auto SourceTime = std::filesystem::last_write_time(filePath, Error);
+    if (!Error && SourceTime > CookedTime) {
+        std::cerr << "[Warn] " << CookedPath << " is older than its source, rerun --cook" << std::endl;
+        return false;
+    }
+
+    CookedTexture Parsed;
+    if (!cooked.Open(CookedPath) || !ParseCookedTexture(cooked.GetData(), cooked.GetSize(), &Parsed)) {
+        std::cerr << "[Warn] Ignoring unreadable " << CookedPath << std::endl;
+        cooked.Close();
+        return false;
+    }
+    return true;
+}
+
+// NOTE: Finest mip the quality tier lets through, every cooked mip halves
+static unsigned
+topMip(const CookedTexture& cooked, TextureQuality quality) {
+    return std::min((unsigned)quality, cooked.Header->MipCount - 1);
+}
+
+// NOTE: Largest mip that is still small enough to show right away
+static unsigned
+firstStreamedMip(const CookedTexture& cooked, TextureQuality quality) {
+    unsigned MipIdx = topMip(cooked, quality);
+    while (MipIdx + 1 < cooked.Header->MipCount
+        && std::max(cooked.Mips[MipIdx].Width, cooked.Mips[MipIdx].Height) > TEXTURE_STREAM_FIRST_MIP_SIZE) {
+        ++MipIdx;
+    }
+    return MipIdx;
+}
+
+// NOTE: GPU bytes of a residence with chains starting at mip resident
+static size_t
+chainBytes(const std::shared_ptr<MappedFile>& file, size_t fullBytes, unsigned mip) {
+    CookedTexture Cooked;
+    if (!file || !ParseCookedTexture(file->GetData(), file->GetSize(), &Cooked)) {
+        return fullBytes;
+    }
+    return Cooked.GetBytes(mip);
+}
+
+TextureLoader::TextureLoader(ThreadPool& pool, TextureQuality quality)
+    : mPool(pool), mQuality(quality), mCookedSupported(GLEW_EXT_texture_compression_s3tc), mPending(0), mDecoding(0),
+    mNextGeneration(0), mJobsInFlight(0) {}
+
+TextureLoader::~TextureLoader() {
+    std::unique_lock<std::mutex> Lock(mMutex);
+    mDecodedAvailable.wait(Lock, [this] { return !mDecoding; });
+    for (DecodedImage& Image : mDecoded) {
+        Texture::FreeImage(Image.Pixels);
+        discard(Image);
+    }
+}
+
+unsigned
+TextureLoader::Load(const std::string& filePath) {
+    unsigned TextureID;
+    glGenTextures(1, &TextureID);
+    Texture::UploadPlaceholder(TextureID, PLACEHOLDER_PIXEL);
+
+    {
+        std::lock_guard<std::mutex> Lock(mMutex);
+        ++mPending;
+        ++mDecoding;
+    }
+
+    mPool.Submit([this, TextureID, filePath] {
+        auto Start = std::chrono::steady_clock::now();
+        DecodedImage Image = { TextureID, filePath, 0, std::make_shared<MappedFile>(), 0, 0, 0, -1, 0, 0, 0, 0, 0.0 };
+        if (mCookedSupported && mapCooked(filePath, *Image.Cooked)) {
+            CookedTexture Cooked;
+            ParseCookedTexture(Image.Cooked->GetData(), Image.Cooked->GetSize(), &Cooked);
+            Image.ContentHash = hashContent(Image.Cooked->GetData(), Image.Cooked->GetSize());
+            Image.Width = Cooked.Mips[topMip(Cooked, mQuality)].Width;
+            Image.Height = Cooked.Mips[topMip(Cooked, mQuality)].Height;
+            Image.Channels = 4;
+            Image.FirstMip = firstStreamedMip(Cooked, mQuality);
+            Image.LastMip = Cooked.Header->MipCount - 1;
+            stageCooked(Image, Cooked);
+        }
+        else {
+            Image.Cooked.reset();
+            decodeSource(Image);
+        }
+
+        Image.DecodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+        finishDecode(Image);
+    });
+    return TextureID;
+}
+
+void
+TextureLoader::SetDecodedCallback(DecodedCallback callback) {
+    mDecodedCallback = callback;
+}
+
+bool
+TextureLoader::stage(DecodedImage& image, const unsigned char* data, size_t size) {
+    image.StagingSlot = mStaging.Acquire(size);
+    if (image.StagingSlot < 0) {
+        return false;
+    }
+    memcpy(mStaging.GetPointer(image.StagingSlot), data, size);
+    return true;
+}
+
+void
+TextureLoader::decodeSource(DecodedImage& image) {
+    // NOTE: Decoded straight from the mapping, then dropped
+    MappedFile Encoded;
+    if (Encoded.Open(image.Path)) {
+        image.ContentHash = hashContent(Encoded.GetData(), Encoded.GetSize());
+        image.Pixels = Texture::DecodeImageFromMemory(Encoded.GetData(), Encoded.GetSize(), &image.Width, &image.Height, &image.Channels, mQuality);
+    }
+    if (image.Pixels && stage(image, image.Pixels, (size_t)image.Width * image.Height * image.Channels)) {
+        Texture::FreeImage(image.Pixels);
+        image.Pixels = 0;
+    }
+}
+
+void
+TextureLoader::stageCooked(DecodedImage& image, const CookedTexture& cooked) {
+    stage(image, cooked.Data + cooked.Mips[image.FirstMip].Offset, cooked.GetChainBytes(image.FirstMip, image.LastMip));
+}
+
+void
+TextureLoader::finishDecode(DecodedImage& image) {
+    std::lock_guard<std::mutex> Lock(mMutex);
+    mDecoded.push_back(std::move(image));
+    --mDecoding;
+    mDecodedAvailable.notify_all();
+}
+
+unsigned
+TextureLoader::Update(double budgetMs) {
+    auto Start = std::chrono::steady_clock::now();
+    unsigned Uploaded = 0;
+    mStaging.Recycle();
+    for (;;) {
+        DecodedImage Image;
+        {
+            std::lock_guard<std::mutex> Lock(mMutex);
+            if (mDecoded.empty()) {
+                break;
+            }
+            Image = std::move(mDecoded.front());
+            mDecoded.pop_front();
+        }
+
+        if (Image.Generation) {
+            uploadRestore(Image);
+        }
+        else {
+            uploadImage(Image);
+        }
+        if (Image.Pixels) {
+            Texture::FreeImage(Image.Pixels);
+        }
+        ++Uploaded;
+
+        double Elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+        if (Elapsed >= budgetMs) {
+            break;
+        }
+    }
+    manageResidency();
+    mResidency.BeginFrame();
+    return Uploaded;
+}
+
+bool
+TextureLoader::upload(DecodedImage& image, const CookedTexture* cooked) {
+    unsigned PixelBuffer = image.StagingSlot >= 0 ? mStaging.BeginUpload(image.StagingSlot) : 0;
+    if (cooked) {
+        const unsigned char* Mips = PixelBuffer ? 0 : cooked->Data + cooked->Mips[image.FirstMip].Offset;
+        Texture::UploadCookedMips(image.Texture, *cooked, image.FirstMip, image.LastMip, Mips, PixelBuffer);
+    }
+    else {
+        Texture::UploadImage(image.Texture, PixelBuffer ? 0 : image.Pixels, image.Width, image.Height, image.Channels, PixelBuffer);
+    }
+
+    if (PixelBuffer) {
+        mStaging.EndUpload(image.StagingSlot);
+        image.StagingSlot = -1;
+    }
+    return PixelBuffer != 0;
+}
+
+void
+TextureLoader::discard(DecodedImage& image) {
+    if (image.StagingSlot >= 0) {
+        mStaging.Release(image.StagingSlot);
+        image.StagingSlot = -1;
+    }
+}
+
+void
+TextureLoader::uploadImage(DecodedImage& image) {
+    CookedTexture Cooked = {};
+    bool IsCooked = image.Cooked && ParseCookedTexture(image.Cooked->GetData(), image.Cooked->GetSize(), &Cooked);
+    bool Failed = !IsCooked && !image.Pixels && image.StagingSlot < 0;
+    unsigned TopMip = IsCooked ? topMip(Cooked, mQuality) : 0;
+    size_t FullBytes = IsCooked ? Cooked.GetBytes(TopMip) : (size_t)image.Width * image.Height * image.Channels * 4 / 3;
+    bool Upload = !Failed;
+    if (mDecodedCallback) {
+        DecodedInfo Info = { image.Texture, image.ContentHash, image.Width, image.Height, image.Channels, FullBytes, Failed };
+        Upload = mDecodedCallback(Info) && Upload;
+    }
+
+    if (!Upload) {
+        if (Failed) {
+            std::cerr << "Failed to load texture: " << image.Path << std::endl;
+        }
+        discard(image);
+        std::lock_guard<std::mutex> Lock(mMutex);
+        --mPending;
+        return;
+    }
+
+    auto UploadStart = std::chrono::steady_clock::now();
+    bool Staged = upload(image, IsCooked ? &Cooked : 0);
+    double UploadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - UploadStart).count();
+    std::cout << "Loaded " << (IsCooked ? "cooked " : "") << "texture: " << image.Path << " (decoded in " << image.DecodeMs
+        << " ms, upload issued in " << UploadMs << " ms" << (Staged ? ", staged" : "") << ")" << std::endl;
+
+    Residence& Resident = mResidences[image.Texture];
+    Resident = { IsCooked ? image.Cooked : 0, image.Path, ++mNextGeneration, FullBytes, TopMip, image.FirstMip, image.FirstMip,
+        false, false, 0, false, 0.0f, std::chrono::steady_clock::now() };
+    mResidency.Track(image.Texture, IsCooked ? Cooked.GetBytes(image.FirstMip) : FullBytes);
+    if (Resident.FinestMip == TopMip) {
+        settle(Resident);
+    }
+}
+
+void
+TextureLoader::uploadRestore(DecodedImage& image) {
+    auto Found = mResidences.find(image.Texture);
+    if (Found == mResidences.end() || Found->second.Generation != image.Generation) {
+        discard(image);
+        return;
+    }
+
+    Residence& Resident = Found->second;
+    Resident.InFlight = false;
+    --mJobsInFlight;
+    mResidency.Reserve(-(ptrdiff_t)Resident.ReservedBytes);
+    Resident.ReservedBytes = 0;
+
+    CookedTexture Cooked = {};
+    bool IsCooked = Resident.File && ParseCookedTexture(Resident.File->GetData(), Resident.File->GetSize(), &Cooked);
+    if (!IsCooked && !image.Pixels && image.StagingSlot < 0) {
+        // NOTE: Stays evicted, the next request tries again
+        std::cerr << "[Warn] Failed to reload texture: " << Resident.Path << std::endl;
+        settle(Resident);
+        return;
+    }
+
+    upload(image, IsCooked ? &Cooked : 0);
+    Resident.Evicted = false;
+    Resident.FinestMip = image.FirstMip;
+    mResidency.Track(image.Texture, IsCooked ? Cooked.GetBytes(Resident.FinestMip) : Resident.FullBytes);
+    if (Resident.FinestMip > Resident.TopMip) {
+        return;
+    }
+
+    if (!Resident.Settled) {
+        double StreamMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Resident.Start).count();
+        std::cout << "Streamed texture to full resolution: " << Resident.Path << " (" << StreamMs << " ms after first mip)" << std::endl;
+    }
+    settle(Resident);
+}
+
+void
+TextureLoader::settle(Residence& residence) {
+    if (residence.Settled) {
+        return;
+    }
+    residence.Settled = true;
+    std::lock_guard<std::mutex> Lock(mMutex);
+    --mPending;
+}
+
+bool
+TextureLoader::shrink(unsigned texture, Residence& residence) {
+    if (residence.InFlight || residence.Evicted) {
+        return false;
+    }
+
+    CookedTexture Cooked;
+    if (residence.File && residence.FinestMip < residence.TailMip
+        && ParseCookedTexture(residence.File->GetData(), residence.File->GetSize(), &Cooked)) {
+        Texture::ReleaseMip(texture, residence.FinestMip++);
+        mResidency.Track(texture, Cooked.GetBytes(residence.FinestMip));
+        return true;
+    }
+
+    Texture::UploadPlaceholder(texture, PLACEHOLDER_PIXEL);
+    residence.Evicted = true;
+    mResidency.Track(texture, sizeof(PLACEHOLDER_PIXEL));
+    return true;
+}
+
+void
+TextureLoader::submitRestore(unsigned texture, Residence& residence, unsigned mip) {
+    {
+        std::lock_guard<std::mutex> Lock(mMutex);
+        ++mDecoding;
+    }
+    residence.InFlight = true;
+    ++mJobsInFlight;
+
+    // NOTE: A resident chain only needs its next finer level, an evicted
+    // texture needs its whole tail back
+    bool Refine = !residence.Evicted;
+    uint64_t Generation = residence.Generation;
+    std::shared_ptr<MappedFile> File = residence.File;
+    std::string Path = residence.Path;
+    mPool.Submit([this, texture, Generation, File, Path, mip, Refine] {
+        auto Start = std::chrono::steady_clock::now();
+        DecodedImage Image = { texture, Path, 0, File, mip, mip, Generation, -1, 0, 0, 0, 0, 0.0 };
+        CookedTexture Cooked;
+        if (File && ParseCookedTexture(File->GetData(), File->GetSize(), &Cooked)) {
+            Image.LastMip = Refine ? mip : Cooked.Header->MipCount - 1;
+            stageCooked(Image, Cooked);
+        }
+        else {
+            decodeSource(Image);
+        }
+        Image.DecodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+        finishDecode(Image);
+    });
+}
+
+void
+TextureLoader::manageResidency() {
+    std::vector<unsigned> Victims = mResidency.GetEvictionOrder();
+    size_t VictimIdx = 0;
+    // NOTE: Shrinks the least recently used texture by one step, moving on
+    // to the next once it's evicted whole
+    auto EvictOne = [&]() {
+        for (; VictimIdx < Victims.size(); ++VictimIdx) {
+            auto Found = mResidences.find(Victims[VictimIdx]);
+            if (Found != mResidences.end() && shrink(Found->first, Found->second)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    while (mResidency.IsOverBudget() && EvictOne()) {
+    }
+
+    std::vector<std::pair<float, unsigned>> Candidates;
+    for (auto& [TextureID, Resident] : mResidences) {
+        if (!Resident.InFlight && (Resident.Evicted || Resident.FinestMip > Resident.TopMip)) {
+            Candidates.emplace_back(Resident.Demand, TextureID);
+        }
+        Resident.Demand = 0.0f;
+    }
+    std::sort(Candidates.begin(), Candidates.end(), std::greater<>());
+
+    for (const auto& [Demand, TextureID] : Candidates) {
+        if (mJobsInFlight >= TEXTURE_STREAM_MAX_IN_FLIGHT) {
+            break;
+        }
+
+        Residence& Resident = mResidences[TextureID];
+        // NOTE: Evicted textures come back at their tail first
+        unsigned Mip = Resident.Evicted ? Resident.TailMip : Resident.FinestMip - 1;
+        size_t Current = Resident.Evicted ? 0 : chainBytes(Resident.File, Resident.FullBytes, Resident.FinestMip);
+        size_t Extra = chainBytes(Resident.File, Resident.FullBytes, Mip) - Current;
+        // NOTE: Only textures drawn last frame may push others out
+        while (!mResidency.Fits(Extra) && Demand > 0.0f && EvictOne()) {
+        }
+        if (!mResidency.Fits(Extra)) {
+            settle(Resident);
+            continue;
+        }
+
+        mResidency.Reserve(Extra);
+        Resident.ReservedBytes = Extra;
+        submitRestore(TextureID, Resident, Mip);
+    }
+}
+
+void
+TextureLoader::RequestResolution(unsigned texture, float screenPixels) {
+    mResidency.Touch(texture);
+    auto Found = mResidences.find(texture);
+    if (Found != mResidences.end()) {
+        Found->second.Demand = std::max(Found->second.Demand, screenPixels);
+    }
+}
+
+void
+TextureLoader::Forget(unsigned texture) {
+    auto Found = mResidences.find(texture);
+    if (Found == mResidences.end()) {
+        return;
+    }
+
+    // NOTE: An in-flight job still arrives, uploadRestore drops it
+    Residence& Resident = Found->second;
+    if (Resident.InFlight) {
+        --mJobsInFlight;
+        mResidency.Reserve(-(ptrdiff_t)Resident.ReservedBytes);
+    }
+    settle(Resident);
+    mResidency.Untrack(texture);
+    mResidences.erase(Found);
+}
+
+TextureResidency&
+TextureLoader::GetResidency() {
+    return mResidency;
+}
+
+void
+TextureLoader::Finish() {
+    for (;;) {
+        // NOTE: Also keeps streaming mips in, nothing else schedules them here
+        Update(1e9);
+        std::unique_lock<std::mutex> Lock(mMutex);
+        if (!mPending) {
+            return;
+        }
+        mDecodedAvailable.wait(Lock, [this] { return !mDecoded.empty(); });
+    }
+}
+
+unsigned
+TextureLoader::GetPendingCount() {
+    std::lock_guard<std::mutex> Lock(mMutex);
+    return mPending;
+}
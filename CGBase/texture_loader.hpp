@@ -0,0 +1,287 @@
+/**
+ * @file texture_loader.hpp
+ * @brief Asynchronous texture loading. Decoding runs on a thread pool and
+ * writes into a staging ring, the render thread only issues the uploads
+ * from it within a per-frame time budget. Textures are kept within a
+ * memory budget by shrinking the least recently drawn ones
+ *
+ */
+
+#pragma once
+#include <string>
+#include <deque>
+#include <memory>
+#include <chrono>
+#include <unordered_map>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include "thread_pool.hpp"
+#include "mapped_file.hpp"
+#include "texture.hpp"
+#include "cooked_texture.hpp"
+#include "texture_staging.hpp"
+#include "texture_residency.hpp"
+
+// NOTE: Upload time allowed per frame. At least one texture is always
+// uploaded so a single large image can't stall loading forever
+static const double TEXTURE_UPLOAD_BUDGET_MS = 4.0;
+// NOTE: Cooked textures first show their largest mip no bigger than this,
+// finer mips stream in one per job afterwards
+static const unsigned TEXTURE_STREAM_FIRST_MIP_SIZE = 64;
+// NOTE: Refinement and reload jobs in flight at once. Few, so a newly
+// visible texture doesn't queue behind everything else
+static const unsigned TEXTURE_STREAM_MAX_IN_FLIGHT = 2;
+
+class TextureLoader {
+public:
+    /**
+     * @brief What a worker found for one requested texture
+     */
+    struct DecodedInfo {
+        unsigned Texture;
+        // NOTE: Hash of the encoded file, 0 if it couldn't be read
+        uint64_t ContentHash;
+        int Width;
+        int Height;
+        int Channels;
+        // NOTE: GPU bytes the upload will take, mips included
+        size_t Bytes;
+        bool Failed;
+    };
+
+    /**
+     * @brief Called on the render thread before each upload
+     *
+     * @returns true - Upload the pixels, false - Drop them
+     */
+    using DecodedCallback = std::function<bool(const DecodedInfo&)>;
+
+    /**
+     * @brief Ctor
+     *
+     * @param pool Pool to decode on, must outlive the loader
+     * @param quality Tier every texture is loaded at. Decoded images are
+     * box filtered down on the worker, cooked ones skip their finest mips
+     */
+    TextureLoader(ThreadPool& pool, TextureQuality quality = TEXTURE_QUALITY_FULL);
+
+    /**
+     * @brief Dtor - waits for in-flight decodes and drops anything not uploaded
+     *
+     */
+    ~TextureLoader();
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    /**
+     * @brief Starts decoding an image. The returned texture is usable right
+     * away and shows a 1x1 placeholder until its upload in Update().
+     * A cooked version (see GetCookedTexturePath) is used instead when it
+     * exists, isn't older than the source and the GPU supports S3TC.
+     * Cooked files are memory mapped and streamed: a small mip shows first,
+     * finer ones follow in later Update() calls
+     *
+     * @param filePath Image file path
+     * @returns TextureID, final - it doesn't change once the image arrives
+     */
+    unsigned Load(const std::string& filePath);
+
+    /**
+     * @brief Sets the callback deciding whether decoded images get uploaded.
+     * Without one everything that decoded is uploaded
+     *
+     * @param callback Callback
+     */
+    void SetDecodedCallback(DecodedCallback callback);
+
+    /**
+     * @brief Uploads decoded images and streamed mips until the budget runs
+     * out, then evicts and schedules streaming to fit the memory budget.
+     * Call once per frame on the render thread, between frames: texture
+     * contents only change here
+     *
+     * @param budgetMs Time budget in milliseconds
+     * @returns Number of images and mips uploaded
+     */
+    unsigned Update(double budgetMs = TEXTURE_UPLOAD_BUDGET_MS);
+
+    /**
+     * @brief Reports that a texture is drawn this frame. Marks it used for
+     * eviction, and textures below full resolution are streamed back
+     * largest on screen first, unreported ones last
+     *
+     * @param texture TextureID
+     * @param screenPixels Projected size of what it's drawn on, in pixels
+     */
+    void RequestResolution(unsigned texture, float screenPixels);
+
+    /**
+     * @brief Stops managing a texture that's about to be deleted
+     *
+     * @param texture TextureID
+     */
+    void Forget(unsigned texture);
+
+    /**
+     * @brief Memory budget and current/peak usage of loaded textures
+     *
+     */
+    TextureResidency& GetResidency();
+
+    /**
+     * @brief Blocks until every requested texture is uploaded at full
+     * resolution, or as close to it as the memory budget allows
+     *
+     */
+    void Finish();
+
+    /**
+     * @brief Number of textures still being decoded, waiting for upload
+     * or streaming in finer mips
+     *
+     */
+    unsigned GetPendingCount();
+private:
+    struct DecodedImage {
+        unsigned Texture;
+        std::string Path;
+        unsigned char* Pixels;
+        // NOTE: Mapped cooked file, used instead of Pixels when set
+        std::shared_ptr<MappedFile> Cooked;
+        // NOTE: Cooked mip levels this carries, finest first
+        unsigned FirstMip;
+        unsigned LastMip;
+        // NOTE: Residence this restores mips or pixels of, 0 for a first load
+        uint64_t Generation;
+        // NOTE: Staging slot holding the pixels or cooked mip chain, -1 if
+        // none was free. Pixels/Cooked are then uploaded directly
+        int StagingSlot;
+        int Width;
+        int Height;
+        int Channels;
+        uint64_t ContentHash;
+        double DecodeMs;
+    };
+
+    // NOTE: A loaded texture. Cooked ones shrink a mip at a time and
+    // stream back, decoded ones are dropped whole and decoded again
+    struct Residence {
+        // NOTE: Cooked file, null for decoded images
+        std::shared_ptr<MappedFile> File;
+        std::string Path;
+        // NOTE: Tells jobs for a forgotten texture from ones for a reused GL name
+        uint64_t Generation;
+        // NOTE: At TopMip, not the cooked file's finest
+        size_t FullBytes;
+        // NOTE: Finest cooked mip the quality tier allows, 0 for decoded images
+        unsigned TopMip;
+        // NOTE: Finest cooked mip resident, the GL texture's base level.
+        // Cooked mips keep their index as GL level, finer levels have no storage
+        unsigned FinestMip;
+        // NOTE: Coarsest starting mip the chain shrinks to before the
+        // texture is evicted whole, see TEXTURE_STREAM_FIRST_MIP_SIZE
+        unsigned TailMip;
+        // NOTE: Down to the placeholder pixel
+        bool Evicted;
+        bool InFlight;
+        size_t ReservedBytes;
+        // NOTE: Counted out of mPending, at full resolution or as far as the budget allowed
+        bool Settled;
+        // NOTE: Largest screen size reported since the last Update
+        float Demand;
+        std::chrono::steady_clock::time_point Start;
+    };
+
+    ThreadPool& mPool;
+    TextureQuality mQuality;
+    DecodedCallback mDecodedCallback;
+    bool mCookedSupported;
+    TextureStaging mStaging;
+    std::mutex mMutex;
+    std::condition_variable mDecodedAvailable;
+    std::deque<DecodedImage> mDecoded;
+    // NOTE: Requested but not yet uploaded, guarded by mMutex
+    unsigned mPending;
+    unsigned mDecoding;
+    // NOTE: Render thread only, by texture
+    std::unordered_map<unsigned, Residence> mResidences;
+    TextureResidency mResidency;
+    uint64_t mNextGeneration;
+    unsigned mJobsInFlight;
+
+    /**
+     * @brief Copies data into a free staging slot, from a worker
+     *
+     * @returns true - Staged, false - No slot free or data too big
+     */
+    bool stage(DecodedImage& image, const unsigned char* data, size_t size);
+
+    /**
+     * @brief Decodes image.Path into image.Pixels or a staging slot, from a worker
+     */
+    void decodeSource(DecodedImage& image);
+
+    /**
+     * @brief Stages image.FirstMip to image.LastMip of the cooked file, from a worker
+     */
+    void stageCooked(DecodedImage& image, const CookedTexture& cooked);
+
+    /**
+     * @brief Hands a decoded image or mip from a worker to the render thread
+     */
+    void finishDecode(DecodedImage& image);
+
+    /**
+     * @brief Issues the upload of a decoded image or cooked mips, from its
+     * staging slot if it has one
+     *
+     * @param cooked Parsed image.Cooked, null for decoded pixels
+     *
+     * @returns true - Uploaded from a staging slot
+     */
+    bool upload(DecodedImage& image, const CookedTexture* cooked);
+
+    /**
+     * @brief Gives back the staging slot of an image that won't be uploaded
+     */
+    void discard(DecodedImage& image);
+
+    /**
+     * @brief Uploads a freshly decoded image and starts managing it
+     */
+    void uploadImage(DecodedImage& image);
+
+    /**
+     * @brief Uploads mips or pixels restoring a managed texture
+     */
+    void uploadRestore(DecodedImage& image);
+
+    /**
+     * @brief Counts a managed texture out of mPending, once
+     */
+    void settle(Residence& residence);
+
+    /**
+     * @brief Drops the finest mip of a cooked texture by raising its base
+     * level and releasing that level alone, or the whole texture once at
+     * its tail or when it isn't cooked
+     *
+     * @returns true - Memory was freed, false - Nothing left to drop or busy
+     */
+    bool shrink(unsigned texture, Residence& residence);
+
+    /**
+     * @brief Submits a job staging the one mip finer than a resident
+     * chain, the whole chain from mip onwards for an evicted texture, or
+     * decoding the source again for textures that aren't cooked
+     */
+    void submitRestore(unsigned texture, Residence& residence, unsigned mip);
+
+    /**
+     * @brief Evicts least recently used textures while over budget and
+     * streams the most demanded ones back up as far as the budget allows
+     */
+    void manageResidency();
+};
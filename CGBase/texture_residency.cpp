@@ -0,0 +1,102 @@
+#include "texture_residency.hpp"
+#include <algorithm>
+#include <iostream>
+
+TextureResidency::TextureResidency(size_t budgetBytes)
+    : mBudget(budgetBytes), mResident(0), mPeak(0), mReserved(0), mFrame(0) {}
+
+void
+TextureResidency::SetBudget(size_t budgetBytes) {
+    mBudget = budgetBytes;
+}
+
+size_t
+TextureResidency::GetBudget() const {
+    return mBudget;
+}
+
+void
+TextureResidency::BeginFrame() {
+    ++mFrame;
+}
+
+void
+TextureResidency::Track(unsigned texture, size_t bytes) {
+    auto Inserted = mEntries.insert({ texture, { 0, mFrame } });
+    mResident = mResident - Inserted.first->second.Bytes + bytes;
+    Inserted.first->second.Bytes = bytes;
+    mPeak = std::max(mPeak, mResident);
+}
+
+void
+TextureResidency::Untrack(unsigned texture) {
+    auto Found = mEntries.find(texture);
+    if (Found != mEntries.end()) {
+        mResident -= Found->second.Bytes;
+        mEntries.erase(Found);
+    }
+}
+
+void
+TextureResidency::Touch(unsigned texture) {
+    auto Found = mEntries.find(texture);
+    if (Found != mEntries.end()) {
+        Found->second.LastUsedFrame = mFrame;
+    }
+}
+
+bool
+TextureResidency::IsInUse(unsigned texture) const {
+    auto Found = mEntries.find(texture);
+    return Found != mEntries.end() && Found->second.LastUsedFrame == mFrame;
+}
+
+std::vector<unsigned>
+TextureResidency::GetEvictionOrder() const {
+    std::vector<std::pair<uint64_t, unsigned>> Unused;
+    for (const auto& [Texture, Tracked] : mEntries) {
+        if (Tracked.LastUsedFrame != mFrame) {
+            Unused.emplace_back(Tracked.LastUsedFrame, Texture);
+        }
+    }
+    std::sort(Unused.begin(), Unused.end());
+
+    std::vector<unsigned> Order;
+    Order.reserve(Unused.size());
+    for (const auto& [LastUsedFrame, Texture] : Unused) {
+        Order.push_back(Texture);
+    }
+    return Order;
+}
+
+void
+TextureResidency::Reserve(ptrdiff_t bytes) {
+    mReserved += bytes;
+}
+
+bool
+TextureResidency::Fits(size_t bytes) const {
+    return mResident + (size_t)std::max<ptrdiff_t>(mReserved, 0) + bytes <= mBudget;
+}
+
+bool
+TextureResidency::IsOverBudget() const {
+    return mResident > mBudget;
+}
+
+size_t
+TextureResidency::GetResidentBytes() const {
+    return mResident;
+}
+
+size_t
+TextureResidency::GetPeakBytes() const {
+    return mPeak;
+}
+
+void
+TextureResidency::PrintStats() const {
+    const double MB = 1024.0 * 1024.0;
+    std::cout << "Texture residency: " << mResident / MB << " MB of " << mBudget / MB << " MB budget, peak "
+        << mPeak / MB << " MB, " << mEntries.size() << " textures" << std::endl;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file texture_residency.hpp
+ * @brief Bookkeeping for texture memory: bytes per texture against a
+ * budget, and when each texture was last drawn so the least recently
+ * used ones can be shrunk first
+ *
+ */
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+
+static const size_t TEXTURE_BUDGET_BYTES = 512ull * 1024 * 1024;
+
+class TextureResidency {
+public:
+    /**
+     * @brief Ctor
+     *
+     * @param budgetBytes GPU bytes textures may take
+     */
+    TextureResidency(size_t budgetBytes = TEXTURE_BUDGET_BYTES);
+
+    void SetBudget(size_t budgetBytes);
+    size_t GetBudget() const;
+
+    /**
+     * @brief Starts a new frame, textures touched from now on count as used in it
+     *
+     */
+    void BeginFrame();
+
+    /**
+     * @brief Starts tracking a texture or updates its size. A newly
+     * tracked texture counts as used this frame
+     *
+     * @param texture TextureID
+     * @param bytes GPU bytes it takes now
+     */
+    void Track(unsigned texture, size_t bytes);
+
+    /**
+     * @brief Stops tracking a texture, no-op if it isn't tracked
+     *
+     * @param texture TextureID
+     */
+    void Untrack(unsigned texture);
+
+    /**
+     * @brief Marks a texture as used this frame, no-op if it isn't tracked
+     *
+     * @param texture TextureID
+     */
+    void Touch(unsigned texture);
+
+    /**
+     * @brief Whether the texture was touched this frame
+     *
+     * @param texture TextureID
+     */
+    bool IsInUse(unsigned texture) const;
+
+    /**
+     * @brief Tracked textures not used this frame, least recently used first
+     *
+     */
+    std::vector<unsigned> GetEvictionOrder() const;
+
+    /**
+     * @brief Sets aside bytes for uploads that are on their way
+     *
+     * @param bytes Bytes, negative to give them back
+     */
+    void Reserve(ptrdiff_t bytes);
+
+    /**
+     * @brief Whether extra bytes fit next to everything resident and reserved
+     *
+     * @param bytes Bytes
+     */
+    bool Fits(size_t bytes) const;
+
+    bool IsOverBudget() const;
+    size_t GetResidentBytes() const;
+    size_t GetPeakBytes() const;
+
+    /**
+     * @brief Logs current and peak usage against the budget
+     *
+     */
+    void PrintStats() const;
+private:
+    struct Entry {
+        size_t Bytes;
+        uint64_t LastUsedFrame;
+    };
+
+    std::unordered_map<unsigned, Entry> mEntries;
+    size_t mBudget;
+    size_t mResident;
+    size_t mPeak;
+    ptrdiff_t mReserved;
+    uint64_t mFrame;
+};
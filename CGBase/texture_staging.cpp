@@ -0,0 +1,123 @@
+#include "texture_staging.hpp"
+#include <iostream>
+
+TextureStaging::TextureStaging(unsigned slotCount, size_t slotBytes)
+    : mSlots(slotCount), mSlotBytes(slotBytes), mPersistent(GLEW_ARB_buffer_storage) {
+    for (unsigned SlotIdx = 0; SlotIdx < slotCount; ++SlotIdx) {
+        Slot& Current = mSlots[SlotIdx];
+        Current.Fence = 0;
+        glGenBuffers(1, &Current.Buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, Current.Buffer);
+        if (mPersistent) {
+            // NOTE: Coherent, writes finished before the upload is issued are seen without a flush
+            GLbitfield Flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_PIXEL_UNPACK_BUFFER, mSlotBytes, 0, Flags);
+            Current.Mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, mSlotBytes, Flags);
+        }
+        else {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, mSlotBytes, 0, GL_STREAM_DRAW);
+            map(Current);
+        }
+
+        if (Current.Mapped) {
+            mFree.push_back(SlotIdx);
+        }
+        else {
+            std::cerr << "[Warn] Failed to map texture staging slot " << SlotIdx << std::endl;
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+TextureStaging::~TextureStaging() {
+    for (Slot& Current : mSlots) {
+        if (Current.Fence) {
+            glDeleteSync(Current.Fence);
+        }
+        // NOTE: Deleting a buffer unmaps it
+        glDeleteBuffers(1, &Current.Buffer);
+    }
+}
+
+int
+TextureStaging::Acquire(size_t bytes) {
+    if (bytes > mSlotBytes) {
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> Lock(mMutex);
+    if (mFree.empty()) {
+        return -1;
+    }
+    int Slot = mFree.back();
+    mFree.pop_back();
+    return Slot;
+}
+
+unsigned char*
+TextureStaging::GetPointer(int slot) const {
+    return mSlots[slot].Mapped;
+}
+
+void
+TextureStaging::Release(int slot) {
+    std::lock_guard<std::mutex> Lock(mMutex);
+    mFree.push_back(slot);
+}
+
+unsigned
+TextureStaging::BeginUpload(int slot) {
+    Slot& Current = mSlots[slot];
+    if (!mPersistent) {
+        // NOTE: GL can't read from a buffer that is mapped without the persistent bit
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, Current.Buffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        Current.Mapped = 0;
+    }
+    return Current.Buffer;
+}
+
+void
+TextureStaging::EndUpload(int slot) {
+    mSlots[slot].Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void
+TextureStaging::Recycle() {
+    for (unsigned SlotIdx = 0; SlotIdx < mSlots.size(); ++SlotIdx) {
+        Slot& Current = mSlots[SlotIdx];
+        if (!Current.Fence) {
+            continue;
+        }
+
+        // NOTE: Zero timeout, only polls
+        GLenum Status = glClientWaitSync(Current.Fence, 0, 0);
+        if (Status != GL_ALREADY_SIGNALED && Status != GL_CONDITION_SATISFIED) {
+            continue;
+        }
+        glDeleteSync(Current.Fence);
+        Current.Fence = 0;
+
+        if (!mPersistent) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, Current.Buffer);
+            map(Current);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+        if (Current.Mapped) {
+            std::lock_guard<std::mutex> Lock(mMutex);
+            mFree.push_back(SlotIdx);
+        }
+    }
+}
+
+bool
+TextureStaging::IsPersistent() const {
+    return mPersistent;
+}
+
+void
+TextureStaging::map(Slot& slot) {
+    // NOTE: Invalidating lets the driver hand out fresh storage instead of syncing
+    slot.Mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, mSlotBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+}
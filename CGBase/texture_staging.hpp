@@ -0,0 +1,105 @@
+/**
+ * @file texture_staging.hpp
+ * @brief Ring of pixel unpack buffers texture data is staged in. Workers
+ * fill slots, the render thread uploads from them and fences recycle them
+ *
+ */
+
+#pragma once
+#include <vector>
+#include <mutex>
+#include <cstddef>
+#include <GL/glew.h>
+
+static const unsigned TEXTURE_STAGING_SLOT_COUNT = 4;
+// NOTE: Fits a 2048x2048 RGBA image, anything bigger is uploaded directly
+static const size_t TEXTURE_STAGING_SLOT_BYTES = 16 * 1024 * 1024;
+
+class TextureStaging {
+public:
+    /**
+     * @brief Ctor - creates the buffers, call on the render thread. Slots
+     * are persistently mapped when ARB_buffer_storage is available,
+     * otherwise mapped while free and unmapped for the upload
+     *
+     * @param slotCount Number of slots
+     * @param slotBytes Size of each slot
+     */
+    TextureStaging(unsigned slotCount = TEXTURE_STAGING_SLOT_COUNT, size_t slotBytes = TEXTURE_STAGING_SLOT_BYTES);
+
+    /**
+     * @brief Dtor - deletes the buffers, call on the render thread
+     *
+     */
+    ~TextureStaging();
+    TextureStaging(const TextureStaging&) = delete;
+    TextureStaging& operator=(const TextureStaging&) = delete;
+
+    /**
+     * @brief Takes a free slot. Never blocks, safe from any thread
+     *
+     * @param bytes Bytes that will be written
+     *
+     * @returns Slot index, -1 if all slots are busy or bytes don't fit
+     */
+    int Acquire(size_t bytes);
+
+    /**
+     * @brief Where to write the slot's contents. Safe from any thread
+     * while the slot is acquired
+     *
+     * @param slot Slot index
+     */
+    unsigned char* GetPointer(int slot) const;
+
+    /**
+     * @brief Returns an acquired slot that won't be uploaded from
+     *
+     * @param slot Slot index
+     */
+    void Release(int slot);
+
+    /**
+     * @brief Gets an acquired slot ready to be read by GL. Render thread only
+     *
+     * @param slot Slot index
+     *
+     * @returns Buffer to bind as GL_PIXEL_UNPACK_BUFFER, data starts at offset 0
+     */
+    unsigned BeginUpload(int slot);
+
+    /**
+     * @brief Fences the uploads issued from the slot. It becomes free again
+     * once the GPU is done with them. Render thread only
+     *
+     * @param slot Slot index
+     */
+    void EndUpload(int slot);
+
+    /**
+     * @brief Frees slots whose uploads finished. Call once per frame on
+     * the render thread
+     *
+     */
+    void Recycle();
+
+    bool IsPersistent() const;
+private:
+    struct Slot {
+        unsigned Buffer;
+        unsigned char* Mapped;
+        GLsync Fence;
+    };
+
+    std::vector<Slot> mSlots;
+    size_t mSlotBytes;
+    bool mPersistent;
+    // NOTE: Free slots, guarded by mMutex. Workers acquire, render thread recycles
+    std::mutex mMutex;
+    std::vector<int> mFree;
+
+    /**
+     * @brief Maps a non-persistent slot for writing
+     */
+    void map(Slot& slot);
+};
@@ -0,0 +1,97 @@
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(unsigned threadCount)
+    : mRunning(0), mStopping(false) {
+    if (!threadCount) {
+        // NOTE: hardware_concurrency may report 0 when unknown
+        unsigned HardwareThreads = std::thread::hardware_concurrency();
+        threadCount = HardwareThreads > 1 ? HardwareThreads - 1 : 1;
+    }
+    mThreads.reserve(threadCount);
+    for (unsigned ThreadIdx = 0; ThreadIdx < threadCount; ++ThreadIdx) {
+        mThreads.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> Lock(mMutex);
+        mStopping = true;
+    }
+    mJobAvailable.notify_all();
+    for (std::thread& Thread : mThreads) {
+        Thread.join();
+    }
+}
+
+void
+ThreadPool::Submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> Lock(mMutex);
+        mJobs.push_back(std::move(job));
+    }
+    mJobAvailable.notify_one();
+}
+
+void
+ThreadPool::WaitIdle() {
+    std::unique_lock<std::mutex> Lock(mMutex);
+    mIdle.wait(Lock, [this] { return mJobs.empty() && !mRunning; });
+}
+
+unsigned
+ThreadPool::GetThreadCount() const {
+    return (unsigned)mThreads.size();
+}
+
+JobGroup::JobGroup(ThreadPool& pool)
+    : mPool(pool), mPending(0) {}
+
+JobGroup::~JobGroup() {
+    Wait();
+}
+
+void
+JobGroup::Submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> Lock(mMutex);
+        ++mPending;
+    }
+    mPool.Submit([this, job = std::move(job)] {
+        job();
+        // NOTE: Notified under the lock, a waiter may destroy the group as soon as it sees zero
+        std::lock_guard<std::mutex> Lock(mMutex);
+        if (!--mPending) {
+            mDone.notify_all();
+        }
+    });
+}
+
+void
+JobGroup::Wait() {
+    std::unique_lock<std::mutex> Lock(mMutex);
+    mDone.wait(Lock, [this] { return !mPending; });
+}
+
+void
+ThreadPool::work() {
+    std::unique_lock<std::mutex> Lock(mMutex);
+    for (;;) {
+        mJobAvailable.wait(Lock, [this] { return mStopping || !mJobs.empty(); });
+        // NOTE: Drain the queue before stopping so nobody waits on a dropped job
+        if (mJobs.empty()) {
+            return;
+        }
+
+        std::function<void()> Job = std::move(mJobs.front());
+        mJobs.pop_front();
+        ++mRunning;
+        Lock.unlock();
+        Job();
+        Lock.lock();
+        --mRunning;
+        if (mJobs.empty() && !mRunning) {
+            mIdle.notify_all();
+        }
+    }
+}
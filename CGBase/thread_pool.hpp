@@ -0,0 +1,99 @@
+/**
+ * @file thread_pool.hpp
+ * @brief Fixed set of worker threads running queued jobs
+ *
+ */
+
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+class ThreadPool {
+public:
+    /**
+     * @brief Ctor - starts the workers
+     *
+     * @param threadCount Number of workers, 0 picks one less than the
+     * number of hardware threads, leaving one for the render thread
+     */
+    ThreadPool(unsigned threadCount = 0);
+
+    /**
+     * @brief Dtor - finishes queued jobs, then joins the workers
+     *
+     */
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queues a job. Jobs must not touch GL, workers have no context
+     *
+     * @param job Job to run on some worker
+     */
+    void Submit(std::function<void()> job);
+
+    /**
+     * @brief Blocks until the queue is empty and no job is running,
+     * including jobs other callers submitted. See JobGroup to wait for
+     * some jobs only
+     *
+     */
+    void WaitIdle();
+
+    unsigned GetThreadCount() const;
+private:
+    std::vector<std::thread> mThreads;
+    std::deque<std::function<void()>> mJobs;
+    std::mutex mMutex;
+    std::condition_variable mJobAvailable;
+    std::condition_variable mIdle;
+    unsigned mRunning;
+    bool mStopping;
+
+    void work();
+};
+
+/**
+ * @brief Jobs submitted to a pool through this group can be waited on
+ * without waiting for the rest of the pool's work
+ */
+class JobGroup {
+public:
+    /**
+     * @brief Ctor
+     *
+     * @param pool Pool running the jobs, must outlive the group
+     */
+    JobGroup(ThreadPool& pool);
+
+    /**
+     * @brief Dtor - waits for the group's jobs, they may reference its owner
+     *
+     */
+    ~JobGroup();
+    JobGroup(const JobGroup&) = delete;
+    JobGroup& operator=(const JobGroup&) = delete;
+
+    /**
+     * @brief Queues a job on the pool, counted in this group
+     *
+     * @param job Job to run on some worker
+     */
+    void Submit(std::function<void()> job);
+
+    /**
+     * @brief Blocks until every job submitted through this group has run
+     *
+     */
+    void Wait();
+private:
+    ThreadPool& mPool;
+    std::mutex mMutex;
+    std::condition_variable mDone;
+    unsigned mPending;
+};
@@ -0,0 +1,150 @@
+/**
+ * @file vertex_format.hpp
+ * @brief Compile-time vertex layouts. Stride, offsets and VAO setup are
+ * all derived from one attribute list, so C++ data and shader inputs
+ * can't drift apart
+ *
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/**
+ * @brief Compact attribute types, read by the shader as floats
+ */
+// NOTE: Normalized to [0, 1] over the mesh bounds, padded to keep attributes 4 byte aligned
+struct QuantizedPosition { uint16_t X, Y, Z, Padding; };
+// NOTE: Octahedral encoding of a unit vector, normalized to [-1, 1]
+struct OctahedralNormal { int16_t X, Y; };
+// NOTE: IEEE 754 half floats
+struct HalfUV { uint16_t U, V; };
+
+/**
+ * @brief GL component type and count of a C++ attribute type
+ */
+template<typename T> struct VertexComponents;
+template<> struct VertexComponents<float> { static constexpr int COUNT = 1; static constexpr GLenum TYPE = GL_FLOAT; static constexpr GLboolean NORMALIZED = GL_FALSE; };
+template<> struct VertexComponents<glm::vec2> { static constexpr int COUNT = 2; static constexpr GLenum TYPE = GL_FLOAT; static constexpr GLboolean NORMALIZED = GL_FALSE; };
+template<> struct VertexComponents<glm::vec3> { static constexpr int COUNT = 3; static constexpr GLenum TYPE = GL_FLOAT; static constexpr GLboolean NORMALIZED = GL_FALSE; };
+template<> struct VertexComponents<glm::vec4> { static constexpr int COUNT = 4; static constexpr GLenum TYPE = GL_FLOAT; static constexpr GLboolean NORMALIZED = GL_FALSE; };
+template<> struct VertexComponents<QuantizedPosition> { static constexpr int COUNT = 3; static constexpr GLenum TYPE = GL_UNSIGNED_SHORT; static constexpr GLboolean NORMALIZED = GL_TRUE; };
+template<> struct VertexComponents<OctahedralNormal> { static constexpr int COUNT = 2; static constexpr GLenum TYPE = GL_SHORT; static constexpr GLboolean NORMALIZED = GL_TRUE; };
+template<> struct VertexComponents<HalfUV> { static constexpr int COUNT = 2; static constexpr GLenum TYPE = GL_HALF_FLOAT; static constexpr GLboolean NORMALIZED = GL_FALSE; };
+
+/**
+ * @brief One shader input, bound to layout (location = Location)
+ */
+template<unsigned Location, typename T>
+struct VertexAttribute {
+    using Type = T;
+    static constexpr unsigned LOCATION = Location;
+    static constexpr unsigned SIZE = sizeof(T);
+    static constexpr int COMPONENTS = VertexComponents<T>::COUNT;
+    static constexpr GLenum COMPONENT_TYPE = VertexComponents<T>::TYPE;
+    static constexpr GLboolean NORMALIZED = VertexComponents<T>::NORMALIZED;
+    static_assert(SIZE % 4 == 0, "Vertex attribute types must keep 4 byte alignment");
+};
+
+/**
+ * @brief Checks that no two attributes share a location
+ */
+template<typename... Attributes>
+constexpr bool
+HasUniqueLocations() {
+    constexpr unsigned Locations[] = { Attributes::LOCATION... };
+    for (unsigned I = 0; I < sizeof...(Attributes); ++I) {
+        for (unsigned J = I + 1; J < sizeof...(Attributes); ++J) {
+            if (Locations[I] == Locations[J]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Interleaved vertex layout, attributes stored in the listed order
+ */
+template<typename... Attributes>
+struct VertexFormat {
+    static constexpr unsigned ATTRIBUTE_COUNT = sizeof...(Attributes);
+    static constexpr unsigned STRIDE = (0 + ... + Attributes::SIZE);
+
+    /**
+     * @brief Byte offset of the attribute at given location
+     */
+    template<unsigned Location>
+    static constexpr unsigned OffsetOf() {
+        static_assert(((Attributes::LOCATION == Location) || ...), "Format has no attribute at this location");
+        unsigned Offset = 0;
+        bool Found = false;
+        ((Found = Found || Attributes::LOCATION == Location, Offset += Found ? 0 : Attributes::SIZE), ...);
+        return Offset;
+    }
+
+    /**
+     * @brief Points and enables every attribute for the currently bound
+     * VAO and GL_ARRAY_BUFFER
+     */
+    static void Setup() {
+        (setupAttribute<Attributes>(), ...);
+    }
+private:
+    static_assert(ATTRIBUTE_COUNT > 0, "Vertex format needs at least one attribute");
+    static_assert(HasUniqueLocations<Attributes...>(), "Vertex attribute locations must be unique");
+
+    template<typename Attribute>
+    static void setupAttribute() {
+        glVertexAttribPointer(Attribute::LOCATION, Attribute::COMPONENTS, Attribute::COMPONENT_TYPE, Attribute::NORMALIZED,
+            STRIDE, (void*)(size_t)OffsetOf<Attribute::LOCATION>());
+        glEnableVertexAttribArray(Attribute::LOCATION);
+    }
+};
+
+// NOTE: Locations match the layout qualifiers in basic.vert and gouraud.vert
+using PositionAttribute = VertexAttribute<0, glm::vec3>;
+using NormalAttribute = VertexAttribute<1, glm::vec3>;
+using UVAttribute = VertexAttribute<2, glm::vec2>;
+// NOTE: Texture array layer, in no vertex buffer. Set per draw with
+// glVertexAttrib1f, or fed from an instance buffer with a divisor of 1
+using LayerAttribute = VertexAttribute<3, float>;
+
+using MeshVertexFormat = VertexFormat<PositionAttribute, NormalAttribute, UVAttribute>;
+
+/**
+ * @brief One vertex of MeshVertexFormat
+ */
+struct MeshVertex {
+    glm::vec3 Position;
+    glm::vec3 Normal;
+    glm::vec2 UV;
+};
+
+static_assert(sizeof(MeshVertex) == MeshVertexFormat::STRIDE, "MeshVertex must match MeshVertexFormat");
+static_assert(offsetof(MeshVertex, Position) == MeshVertexFormat::OffsetOf<PositionAttribute::LOCATION>(), "MeshVertex must match MeshVertexFormat");
+static_assert(offsetof(MeshVertex, Normal) == MeshVertexFormat::OffsetOf<NormalAttribute::LOCATION>(), "MeshVertex must match MeshVertexFormat");
+static_assert(offsetof(MeshVertex, UV) == MeshVertexFormat::OffsetOf<UVAttribute::LOCATION>(), "MeshVertex must match MeshVertexFormat");
+
+// NOTE: Same locations as MeshVertexFormat, shaders built with COMPACT_VERTICES decode them
+using CompactPositionAttribute = VertexAttribute<0, QuantizedPosition>;
+using CompactNormalAttribute = VertexAttribute<1, OctahedralNormal>;
+using CompactUVAttribute = VertexAttribute<2, HalfUV>;
+
+using CompactMeshVertexFormat = VertexFormat<CompactPositionAttribute, CompactNormalAttribute, CompactUVAttribute>;
+
+/**
+ * @brief One vertex of CompactMeshVertexFormat, half the size of MeshVertex
+ */
+struct CompactMeshVertex {
+    QuantizedPosition Position;
+    OctahedralNormal Normal;
+    HalfUV UV;
+};
+
+static_assert(sizeof(CompactMeshVertex) == CompactMeshVertexFormat::STRIDE, "CompactMeshVertex must match CompactMeshVertexFormat");
+static_assert(offsetof(CompactMeshVertex, Position) == CompactMeshVertexFormat::OffsetOf<CompactPositionAttribute::LOCATION>(), "CompactMeshVertex must match CompactMeshVertexFormat");
+static_assert(offsetof(CompactMeshVertex, Normal) == CompactMeshVertexFormat::OffsetOf<CompactNormalAttribute::LOCATION>(), "CompactMeshVertex must match CompactMeshVertexFormat");
+static_assert(offsetof(CompactMeshVertex, UV) == CompactMeshVertexFormat::OffsetOf<CompactUVAttribute::LOCATION>(), "CompactMeshVertex must match CompactMeshVertexFormat");
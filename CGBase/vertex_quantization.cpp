@@ -0,0 +1,143 @@
+#include "vertex_quantization.hpp"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+static const float QUANTIZED_POSITION_MAX = 65535.0f;
+static const float OCTAHEDRAL_MAX = 32767.0f;
+
+uint16_t
+FloatToHalf(float value) {
+    uint32_t Bits;
+    memcpy(&Bits, &value, sizeof(Bits));
+    uint32_t Sign = (Bits >> 16) & 0x8000;
+    uint32_t Magnitude = Bits & 0x7FFFFFFF;
+    // NOTE: Infinity and NaN, which stays a NaN
+    if (Magnitude >= 0x7F800000) {
+        return (uint16_t)(Sign | (Magnitude > 0x7F800000 ? 0x7E00 : 0x7C00));
+    }
+    // NOTE: 65520 and up round past the largest half
+    if (Magnitude >= 0x477FF000) {
+        return (uint16_t)(Sign | 0x7C00);
+    }
+    // NOTE: Normal halves start at 2^-14, rebias the exponent and round to nearest even
+    if (Magnitude >= 0x38800000) {
+        return (uint16_t)(Sign | ((Magnitude - 0x38000000 + 0xFFF + ((Magnitude >> 13) & 1)) >> 13));
+    }
+    // NOTE: Below half of the smallest subnormal
+    if (Magnitude < 0x33000000) {
+        return (uint16_t)Sign;
+    }
+
+    uint32_t Mantissa = (Magnitude & 0x7FFFFF) | 0x800000;
+    uint32_t Shift = 126 - (Magnitude >> 23);
+    uint32_t Half = Mantissa >> Shift;
+    uint32_t Remainder = Mantissa & ((1u << Shift) - 1);
+    uint32_t Halfway = 1u << (Shift - 1);
+    if (Remainder > Halfway || (Remainder == Halfway && (Half & 1))) {
+        ++Half;
+    }
+    return (uint16_t)(Sign | Half);
+}
+
+float
+HalfToFloat(uint16_t value) {
+    uint32_t Sign = (uint32_t)(value & 0x8000) << 16;
+    uint32_t Exponent = (value >> 10) & 0x1F;
+    uint32_t Mantissa = value & 0x3FF;
+    if (!Exponent) {
+        float Subnormal = std::ldexp((float)Mantissa, -24);
+        return Sign ? -Subnormal : Subnormal;
+    }
+
+    uint32_t Bits = Sign | (Exponent == 0x1F ? 0x7F800000 : (Exponent + 112) << 23) | (Mantissa << 13);
+    float Result;
+    memcpy(&Result, &Bits, sizeof(Result));
+    return Result;
+}
+
+static float
+signNotZero(float value) {
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+OctahedralNormal
+EncodeOctahedral(const glm::vec3& normal) {
+    float Length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (Length == 0.0f) {
+        return OctahedralNormal{ 0, 0 };
+    }
+
+    // NOTE: Projects onto the octahedron, then folds the lower half over the diagonals
+    float X = normal.x / Length;
+    float Y = normal.y / Length;
+    if (normal.z < 0.0f) {
+        float FoldedX = (1.0f - std::abs(Y)) * signNotZero(X);
+        float FoldedY = (1.0f - std::abs(X)) * signNotZero(Y);
+        X = FoldedX;
+        Y = FoldedY;
+    }
+    return OctahedralNormal{
+        (int16_t)std::lround(std::min(std::max(X, -1.0f), 1.0f) * OCTAHEDRAL_MAX),
+        (int16_t)std::lround(std::min(std::max(Y, -1.0f), 1.0f) * OCTAHEDRAL_MAX)
+    };
+}
+
+glm::vec3
+DecodeOctahedral(OctahedralNormal normal) {
+    // NOTE: Same as GL's signed normalized conversion and DecodeNormal in basic.vert
+    float X = std::max(normal.X / OCTAHEDRAL_MAX, -1.0f);
+    float Y = std::max(normal.Y / OCTAHEDRAL_MAX, -1.0f);
+    float Z = 1.0f - std::abs(X) - std::abs(Y);
+    float Fold = std::max(-Z, 0.0f);
+    X += X >= 0.0f ? -Fold : Fold;
+    Y += Y >= 0.0f ? -Fold : Fold;
+    float Length = std::sqrt(X * X + Y * Y + Z * Z);
+    return glm::vec3(X / Length, Y / Length, Z / Length);
+}
+
+QuantizationError
+QuantizeVertices(const MeshVertex* vertices, unsigned count, const glm::vec3& origin, const glm::vec3& extent, CompactMeshVertex* out) {
+    QuantizationError Error = { 0.0f, 0.0f, 0.0f, 0.0f };
+    float MaxCos = 1.0f;
+    for (unsigned VertexIdx = 0; VertexIdx < count; ++VertexIdx) {
+        const MeshVertex& Source = vertices[VertexIdx];
+        CompactMeshVertex Vertex;
+        uint16_t* Position = &Vertex.Position.X;
+        for (int Axis = 0; Axis < 3; ++Axis) {
+            float Normalized = extent[Axis] > 0.0f ? (Source.Position[Axis] - origin[Axis]) / extent[Axis] : 0.0f;
+            Position[Axis] = (uint16_t)std::lround(std::min(std::max(Normalized, 0.0f), 1.0f) * QUANTIZED_POSITION_MAX);
+            float Decoded = origin[Axis] + Position[Axis] / QUANTIZED_POSITION_MAX * extent[Axis];
+            Error.Position = std::max(Error.Position, std::abs(Decoded - Source.Position[Axis]));
+        }
+        Vertex.Position.Padding = 0;
+
+        Vertex.Normal = EncodeOctahedral(Source.Normal);
+        float NormalLength = std::sqrt(glm::dot(Source.Normal, Source.Normal));
+        if (NormalLength > 0.0f) {
+            glm::vec3 Decoded = DecodeOctahedral(Vertex.Normal);
+            MaxCos = std::min(MaxCos, glm::dot(Decoded, Source.Normal) / NormalLength);
+        }
+
+        Vertex.UV.U = FloatToHalf(Source.UV.x);
+        Vertex.UV.V = FloatToHalf(Source.UV.y);
+        Error.UV = std::max(Error.UV, std::abs(HalfToFloat(Vertex.UV.U) - Source.UV.x));
+        Error.UV = std::max(Error.UV, std::abs(HalfToFloat(Vertex.UV.V) - Source.UV.y));
+        out[VertexIdx] = Vertex;
+    }
+
+    float Diagonal = std::sqrt(glm::dot(extent, extent));
+    Error.PositionRelative = Diagonal > 0.0f ? Error.Position / Diagonal : 0.0f;
+    Error.NormalDegrees = std::acos(std::min(std::max(MaxCos, -1.0f), 1.0f)) * 57.29578f;
+    return Error;
+}
+
+std::string
+FormatQuantizationError(const QuantizationError& error) {
+    std::ostringstream Out;
+    Out << std::setprecision(3) << "position error <= " << error.Position << " (" << error.PositionRelative * 100.0f
+        << "% of bounds), normal <= " << error.NormalDegrees << " deg, UV <= " << error.UV;
+    return Out.str();
+}
@@ -0,0 +1,56 @@
+/**
+ * @file vertex_quantization.hpp
+ * @brief Conversion of MeshVertex into CompactMeshVertex: positions
+ * quantized over the mesh bounds, octahedral normals and half float UVs,
+ * along with how far the result is from the original
+ *
+ */
+
+#pragma once
+#include <string>
+#include "vertex_format.hpp"
+
+enum VertexPrecision {
+    // NOTE: MeshVertex and 32 bit indices
+    VERTEX_PRECISION_FULL = 0,
+    // NOTE: CompactMeshVertex, and 16 bit indices for meshes with at most 65536 vertices
+    VERTEX_PRECISION_COMPACT = 1,
+};
+
+/**
+ * @brief Largest difference between original and decoded vertices of a mesh
+ */
+struct QuantizationError {
+    // NOTE: In model units, and relative to the diagonal of the mesh bounds
+    float Position;
+    float PositionRelative;
+    float NormalDegrees;
+    float UV;
+};
+
+/**
+ * @brief Quantizes vertices and measures the error of each one decoded
+ * again the way the shader does it
+ *
+ * @param vertices Vertices
+ * @param count Number of vertices
+ * @param origin Mesh bounds minimum, decodes from 0
+ * @param extent Mesh bounds size, decodes from 1
+ * @param out count vertices, written sequentially and never read
+ *
+ * @returns Largest errors over all vertices
+ */
+QuantizationError QuantizeVertices(const MeshVertex* vertices, unsigned count, const glm::vec3& origin, const glm::vec3& extent, CompactMeshVertex* out);
+
+/**
+ * @brief Conversions used by QuantizeVertices, exposed for tools
+ */
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t value);
+OctahedralNormal EncodeOctahedral(const glm::vec3& normal);
+glm::vec3 DecodeOctahedral(OctahedralNormal normal);
+
+/**
+ * @brief One line summary for load logs
+ */
+std::string FormatQuantizationError(const QuantizationError& error);